@@ -0,0 +1,116 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef ARENA_ALLOCATOR_H
+#define ARENA_ALLOCATOR_H
+
+#include "foundation.h"
+#include "nodecpp_assert.h"
+#include "page_allocator.h"
+#include <cstddef>
+
+namespace nodecpp
+{
+
+// ArenaAllocator: a bump allocator over a range of address space that is reserved once (by VirtualMemory::AllocateAddressSpace())
+// and committed incrementally, by commitChunkSize bytes, as allocations advance.
+//   - allocations are not freed individually; instead, the arena can be rewound to a previously taken checkpoint, or reset
+//     (both are O(1) and keep memory committed, so the next round of allocations does not touch OS at all)
+//   - releaseUnused() gives memory committed beyond the current position (or beyond a given size to keep) back to OS
+//   - with VirtualMemory::prefault (and/or lockInMemory) flags, memory is populated as it is committed; commitAhead(), called 
+//     off the hot path (say, between requests), commits and populates memory ahead of the current position
+//   - addresses never change, so everything allocated stays valid until rewound beyond
+// NOTE: an arena is not thread-safe; destructors of objects placed in an arena are not called
+class ArenaAllocator
+{
+public:
+	static constexpr size_t defaultReservedSize = 0x40000000; // 1Gb (address space only)
+	static constexpr size_t defaultCommitChunkSize = 0x10000; // 64Kb
+
+	struct Checkpoint
+	{
+		uint8_t* pos;
+	};
+
+private:
+	uint8_t* begin_ = nullptr;
+	uint8_t* pos = nullptr;
+	uint8_t* committedEnd = nullptr;
+	uint8_t* reservedEnd = nullptr;
+	size_t commitChunkSize;
+	uint32_t commitFlags;
+	MemoryTag tag;
+
+	void* allocateSlow( size_t sz, size_t alignment );
+	void commitUpTo( uint8_t* end, uint32_t flags );
+
+public:
+	ArenaAllocator( size_t reservedSize = defaultReservedSize, size_t commitChunkSize_ = defaultCommitChunkSize, uint32_t flags = VirtualMemory::noFlags, MemoryTag tag_ = MemoryTag::arena );
+	ArenaAllocator( const ArenaAllocator& ) = delete;
+	ArenaAllocator& operator = ( const ArenaAllocator& ) = delete;
+	ArenaAllocator( ArenaAllocator&& ) = delete;
+	ArenaAllocator& operator = ( ArenaAllocator&& ) = delete;
+	~ArenaAllocator();
+
+	// alignment must be a power of 2
+	NODECPP_FORCEINLINE void* allocate( size_t sz, size_t alignment = alignof(std::max_align_t) )
+	{
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, alignment != 0 && ( alignment & ( alignment - 1 ) ) == 0, "{}", alignment );
+		uintptr_t ret = ( (uintptr_t)pos + alignment - 1 ) & ~( (uintptr_t)alignment - 1 );
+		if ( NODECPP_LIKELY( ret <= (uintptr_t)committedEnd && sz <= (uintptr_t)committedEnd - ret ) )
+		{
+			pos = reinterpret_cast<uint8_t*>( ret ) + sz;
+			return reinterpret_cast<void*>( ret );
+		}
+		return allocateSlow( sz, alignment );
+	}
+
+	template<class T>
+	T* allocate( size_t cnt = 1 ) { return reinterpret_cast<T*>( allocate( sizeof(T) * cnt, alignof(T) ) ); }
+
+	Checkpoint checkpoint() const { return Checkpoint{ pos }; }
+	void rewind( Checkpoint cp )
+	{
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, cp.pos >= begin_ && cp.pos <= pos, "0x{:x} out of [0x{:x}, 0x{:x}]", (uintptr_t)(cp.pos), (uintptr_t)begin_, (uintptr_t)pos );
+		pos = cp.pos;
+	}
+	void reset() { pos = begin_; }
+
+	// decommits everything beyond max( usedSize(), keepSize ) rounded up to a page size
+	// (decommitFlags: VirtualMemory::releaseCommitCharge to give commit charge back as well, see VirtualMemory::DecommitMemory())
+	void releaseUnused( size_t keepSize = 0, uint32_t decommitFlags = VirtualMemory::noFlags );
+	// makes sure that next size bytes (or whatever remains of the reserved range) are committed and populated
+	void commitAhead( size_t size );
+
+	size_t usedSize() const { return pos - begin_; }
+	size_t committedSize() const { return committedEnd - begin_; }
+	size_t reservedSize() const { return reservedEnd - begin_; }
+};
+
+} // namespace nodecpp
+
+#endif // ARENA_ALLOCATOR_H
@@ -0,0 +1,105 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace nodecpp
+{
+
+// CRC32C (Castagnoli): by SSE4.2 instructions on x64 (when the CPU has them), by ARMv8 CRC instructions when compiled for them, 
+// by a slicing-by-8 table otherwise. crc is that of preceding data, if any, so that crc32c( b, crc32c( a ) ) == crc32c( a + b )
+uint32_t crc32c( const void* data, size_t sz, uint32_t crc = 0 );
+uint32_t crc32cSoftware( const void* data, size_t sz, uint32_t crc = 0 ); // the table-based one, regardless of the CPU
+const char* crc32cImplementation();
+
+namespace impl {
+	// calls fn( data, size ) for each directly available block of up to sz bytes from it on
+	template<class ReadIterT, class Fn>
+	void forEachBlock( ReadIterT& it, size_t sz, Fn fn )
+	{
+		while ( sz != 0 && it.directlyAvailableSize() != 0 )
+		{
+			size_t chunk = sz < it.directlyAvailableSize() ? sz : it.directlyAvailableSize();
+			fn( it.directRead( chunk ), chunk );
+			sz -= chunk;
+		}
+	}
+} // namespace impl
+
+// Checksums and hashes of data given piece by piece, both as memory ranges and as ranges of messages (say, 
+// update( msg.getReadIter( offset ), sz ), page by page); updating them right after appending to a message 
+// gets a checksum of the message with data still in cache
+class Crc32c
+{
+	uint32_t crc = 0;
+
+public:
+	void update( const void* data, size_t sz ) { crc = crc32c( data, sz, crc ); }
+	template<class ReadIterT, class = decltype( std::declval<ReadIterT&>().directRead( 0 ) )>
+	void update( ReadIterT it, size_t sz )
+	{
+		impl::forEachBlock( it, sz, [this]( const uint8_t* data, size_t chunk ) { update( data, chunk ); } );
+	}
+	uint32_t value() const { return crc; }
+};
+
+// XXH64 (non-cryptographic, 64-bit; outputs are those of the reference implementation)
+class XXH64
+{
+	uint64_t acc[4];
+	uint8_t buff[32];
+	size_t buffSz = 0;
+	uint64_t totalSz = 0;
+	uint64_t seed;
+
+public:
+	explicit XXH64( uint64_t seed_ = 0 ) { reset( seed_ ); }
+	void reset( uint64_t seed_ = 0 );
+	void update( const void* data, size_t sz );
+	template<class ReadIterT, class = decltype( std::declval<ReadIterT&>().directRead( 0 ) )>
+	void update( ReadIterT it, size_t sz )
+	{
+		impl::forEachBlock( it, sz, [this]( const uint8_t* data, size_t chunk ) { update( data, chunk ); } );
+	}
+	uint64_t digest() const;
+
+	static uint64_t hash( const void* data, size_t sz, uint64_t seed = 0 )
+	{
+		XXH64 h( seed );
+		h.update( data, sz );
+		return h.digest();
+	}
+};
+
+} // namespace nodecpp
+
+#endif // CHECKSUM_H
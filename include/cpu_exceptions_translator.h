@@ -32,6 +32,9 @@
 #include <stdexcept>
 
 void initTranslator();
+// (where applicable) sets up an alternate signal stack for the calling thread, so that a StackOverflowException 
+// can be reported when the thread's current stack is exhausted; initTranslator() does it for the thread it is called from
+void initTranslatorSignalStack();
 
 class MemoryAccessViolationException : public std::exception {
 	static constexpr size_t buffsz = 0x100;
@@ -43,6 +46,16 @@ public:
 
 };
 
+class StackOverflowException : public std::exception {
+	static constexpr size_t buffsz = 0x100;
+	char whatText[buffsz];
+public:
+	StackOverflowException( void* p ) { auto res = fmt::format_to_n( whatText, buffsz - 1, "Stack Overflow (guard page access at 0x{:x})", (size_t)p ); if ( res.size >= buffsz ) whatText[buffsz-1] = 0; else whatText[res.size] = 0; }
+	StackOverflowException( const StackOverflowException& other ) = default;
+	const char* what() const noexcept override {  return whatText; };
+
+};
+
 class NullPointerException : public std::exception {
 public:
 	const char* what() const noexcept override { return "Null Ptr Access"; };
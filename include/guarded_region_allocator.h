@@ -0,0 +1,89 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef GUARDED_REGION_ALLOCATOR_H
+#define GUARDED_REGION_ALLOCATOR_H
+
+#include "foundation.h"
+#include "page_allocator.h"
+#include <mutex>
+#include <vector>
+
+namespace nodecpp
+{
+
+// GuardedRegionAllocator: hands out fixed-size regions (typically, coroutine/fiber stacks) carved from a single reservation
+// of address space; each region is surrounded by never-committed guard pages:
+//     [guard][region 0][guard][region 1] ... [guard][region maxRegions-1][guard]
+//   - a region is committed when handed out for the first time; deallocated regions go to a free list and are reused 
+//     as is (most recently freed first); trim() decommits regions in the free list
+//   - an access to a guard page is reported by the CPU exception translator (see initTranslator()) as StackOverflowException
+// NOTE: on Linux each committed region with its guard takes two memory mappings (VMAs), and the number of those 
+//       is limited per process by vm.max_map_count (65530 by default)
+class GuardedRegionAllocator
+{
+public:
+	static constexpr size_t maxInstances = 64; // alive at the same time; checked by isGuardAddress()
+
+private:
+	uint8_t* base = nullptr;
+	size_t regionSz;
+	size_t guardSz;
+	size_t slotSz; // guardSz + regionSz
+	size_t maxRegionCnt;
+
+	std::mutex mx;
+	size_t unusedSlotIdx = 0; // slots starting from this one have never been handed out
+	std::vector<void*> freeRegions; // committed
+	std::vector<void*> trimmedRegions; // need to be committed again
+
+	bool isRegionStart( const void* region ) const;
+
+public:
+	// regionSize and guardSize are rounded up to a page size; guardSize of 0 means a single page
+	GuardedRegionAllocator( size_t regionSize, size_t maxRegions, size_t guardSize = 0 );
+	GuardedRegionAllocator( const GuardedRegionAllocator& ) = delete;
+	GuardedRegionAllocator& operator = ( const GuardedRegionAllocator& ) = delete;
+	GuardedRegionAllocator( GuardedRegionAllocator&& ) = delete;
+	GuardedRegionAllocator& operator = ( GuardedRegionAllocator&& ) = delete;
+	~GuardedRegionAllocator();
+
+	void* allocate(); // returns the lowest address of a region; for a downward-growing stack, its top is that plus regionSize()
+	void deallocate( void* region );
+	void trim();
+
+	size_t regionSize() const { return regionSz; }
+	size_t guardSize() const { return guardSz; }
+	size_t maxRegions() const { return maxRegionCnt; }
+
+	// whether addr belongs to a guard page of any alive allocator; async-signal-safe
+	static bool isGuardAddress( const void* addr );
+};
+
+} // namespace nodecpp
+
+#endif // GUARDED_REGION_ALLOCATOR_H
@@ -30,15 +30,22 @@
 
 #include "foundation.h"
 #include "page_allocator.h"
+#include "page_pool.h"
 #ifdef NODECPP_WINDOWS
 #include <intrin.h>
+#else
+#include <sys/uio.h>
 #endif
+#include <string>
+#include <string_view>
+#include <type_traits>
 
 namespace nodecpp::platform::internal_msg { 
 
-	constexpr size_t pageSize = 0x1000;
+	constexpr size_t pageSize = 0x1000; // default; actual page size of a message is that of its page provider
 	constexpr size_t pageSizeExp = 12;
 	static_assert( (1<<pageSizeExp) == pageSize );
+	constexpr size_t minPageSize = 0x200;
 
 	struct PagePtrWrapper
 	{
@@ -58,27 +65,96 @@ namespace nodecpp::platform::internal_msg {
 		void init( void* page ) {ptr = reinterpret_cast<uint8_t*>(page); }
 	};
 
+	// a buffer for scatter/gather I/O (see ReadIter::gather() and InternalMsgImpl::prepareReceive()): struct iovec, 
+	// as is, for writev()/readv()/sendmsg()/recvmsg(); on Windows, a struct with the same members to be converted to WSABUF
+#ifdef NODECPP_WINDOWS
+	struct IoVec
+	{
+		void* iov_base;
+		size_t iov_len;
+	};
+#else
+	using IoVec = ::iovec;
+#endif
+
+	// data in messages is little-endian; this is a no-op on all currently supported platforms
+	template<class T>
+	T nativeToLE( T val )
+	{
+		static_assert( std::is_integral_v<T> );
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		T ret;
+		const uint8_t* src = reinterpret_cast<const uint8_t*>( &val );
+		uint8_t* dst = reinterpret_cast<uint8_t*>( &ret );
+		for ( size_t i=0; i<sizeof(T); ++i )
+			dst[i] = src[sizeof(T) - 1 - i];
+		return ret;
+#else
+		return val;
+#endif
+	}
+	template<class T>
+	T LEToNative( T val ) { return nativeToLE( val ); }
+
+	constexpr size_t maxVarUintSize = 10; // LEB128 of a 64-bit value
+
 	using PagePointer = PagePtrWrapper;
 //	using PagePointer = page_ptr_and_data;
 
-	class MallocPageProvider // used just for interface purposes
+	// Page providers: static acquirePage() returning a PagePointer to pageSize bytes (a power of 2, at least minPageSize; static constexpr pageSize of a provider), 
+	// and static releasePage( PagePointer ); PagePointer is a type of a provider, too (PagePtrWrapper, unless pages are referred to otherwise, see internal_msg_shm.h);
+	// if canSharePages, static sharePage( PagePointer ) adds a holder to a page, and releasePage() frees it when the last holder is gone;
+	// static isPageShared( PagePointer ) tells whether there is more than one holder.
+	// A small message is kept as a whole in a cell of cellSize bytes, from static acquireCell(), released by static releaseCell( PagePointer ), 
+	// and is moved to a page when it grows; cellSize == 0 if there are no cells
+
+	// larger pages mean fewer index pages and page boundaries for bulk data, smaller ones mean less memory for small messages
+	template<size_t pageSize_>
+	class MallocPageProviderT
 	{
 	public:
+		using PagePointer = internal_msg::PagePointer;
+		static constexpr size_t pageSize = pageSize_;
+		static constexpr bool canSharePages = false;
+		static constexpr size_t cellSize = pageSize > 0x200 ? 0x200 : 0;
 		static PagePointer acquirePage() { return PagePointer( ::malloc( pageSize ) ); }
 		static void releasePage( PagePointer page ) { ::free( page.page() ); }
+		static PagePointer acquireCell() { return PagePointer( ::malloc( cellSize ) ); }
+		static void releaseCell( PagePointer cell ) { ::free( cell.page() ); }
+	};
+	using MallocPageProvider = MallocPageProviderT<pageSize>;
+
+	class PoolPageProvider // pages are page-aligned and, in steady state, served from a per-thread cache (see PagePool)
+	{
+	public:
+		using PagePointer = internal_msg::PagePointer;
+		static constexpr size_t pageSize = PagePool::pageSize;
+		static constexpr bool canSharePages = true;
+		static PagePointer acquirePage() { return PagePointer( PagePool::acquirePage() ); }
+		static void releasePage( PagePointer page ) { PagePool::releasePage( page.page() ); }
+		static void sharePage( PagePointer page ) { PagePool::addRef( page.page() ); }
+		static bool isPageShared( PagePointer page ) { return PagePool::isShared( page.page() ); }
+		static constexpr size_t cellSize = PagePool::cellSize;
+		static PagePointer acquireCell() { return PagePointer( PagePool::acquireCell() ); }
+		static void releaseCell( PagePointer cell ) { PagePool::releaseCell( cell.page() ); }
 	};
 
-	class InternalMsg
+	template<class PageProvider>
+	class InternalMsgImpl
 	{
+	public:
+		using PagePointer = typename PageProvider::PagePointer;
+		static constexpr size_t pageSize = PageProvider::pageSize;
+		static_assert( pageSize >= minPageSize && ( pageSize & ( pageSize - 1 ) ) == 0 );
+
+	private:
 		PagePointer implAcquirePageWrapper()
 		{
-			return MallocPageProvider::acquirePage();
-			//return globalPagePool.acquirePage();
+			return PageProvider::acquirePage();
 		}
 		void implReleasePageWrapper( PagePointer page )
 		{
-			MallocPageProvider::releasePage( page );
-			//globalPagePool.releasePage( page );
+			PageProvider::releasePage( page );
 		}
 		struct IndexPageHeader
 		{
@@ -111,6 +187,24 @@ namespace nodecpp::platform::internal_msg {
 			const IndexPageHeader* next() const { return reinterpret_cast<const IndexPageHeader*>( next_.page() ); }
 		};
 		static constexpr size_t maxAddressedByPage = ( pageSize - sizeof( IndexPageHeader ) ) / sizeof( uint8_t*);
+		// the first index page (addressing pages from localStorageSize on) is a cell, if there are cells: a message of a few pages 
+		// then takes a small fraction of a page, rather than a whole page, for its index
+		static constexpr size_t maxAddressedByFirstIndexPage = PageProvider::cellSize != 0 ? ( PageProvider::cellSize - sizeof( IndexPageHeader ) ) / sizeof( PagePointer ) : maxAddressedByPage;
+		static_assert( maxAddressedByFirstIndexPage != 0 );
+		PagePointer implAcquireFirstIndexPage()
+		{
+			if constexpr ( PageProvider::cellSize != 0 )
+				return PageProvider::acquireCell();
+			else
+				return implAcquirePageWrapper();
+		}
+		void implReleaseFirstIndexPage( PagePointer page )
+		{
+			if constexpr ( PageProvider::cellSize != 0 )
+				PageProvider::releaseCell( page );
+			else
+				implReleasePageWrapper( page );
+		}
 
 		static constexpr size_t localStorageSize = 4;
 		struct FirstHeader : public IndexPageHeader
@@ -144,20 +238,115 @@ namespace nodecpp::platform::internal_msg {
 		size_t pageCnt = 0; // payload pages (that is, not include index pages)
 		PagePointer lip;
 		IndexPageHeader* lastIndexPage() { return reinterpret_cast<IndexPageHeader*>( lip.page() ); }
+		// index pages past the first linked one are also reachable through a radix tree of directory pages (each is an array of
+		// maxAddressedByDirPage PagePointers), so that random access takes a hop per level rather than a hop per index page;
+		// while there is a single such index page, dirRoot is that index page itself
+		PagePointer dirRoot;
 		PagePointer currentPage;
 		size_t totalSz = 0;
+		size_t cellSz = 0; // if not 0, the first (and the only) page is a cell of that size; it is never filled up (see implPromoteCell())
 
 		size_t offsetInCurrentPage() const { return totalSz & ( pageSize - 1 ); }
-		size_t remainingSizeInCurrentPage() const { return pageSize - offsetInCurrentPage(); }
+		size_t remainingSizeInCurrentPage() const { return ( cellSz ? cellSz : pageSize ) - offsetInCurrentPage(); }
+		static constexpr size_t maxAddressedByDirPage = pageSize / sizeof( PagePointer );
+		static PagePointer* implDirEntries( PagePointer dirPage ) { return reinterpret_cast<PagePointer*>( dirPage.page() ); }
+		// index pages in the directory for a given number of payload pages
+		static size_t implDirIndexPageCnt( size_t payloadPageCnt )
+		{
+			constexpr size_t addressedBeforeDir = localStorageSize + maxAddressedByFirstIndexPage;
+			return payloadPageCnt > addressedBeforeDir ? ( payloadPageCnt - addressedBeforeDir + maxAddressedByPage - 1 ) / maxAddressedByPage : 0;
+		}
+		// levels of directory pages above indexPageCnt index pages
+		static size_t implDirDepth( size_t indexPageCnt )
+		{
+			size_t depth = 0;
+			for ( size_t span = 1; span < indexPageCnt; span *= maxAddressedByDirPage )
+				++depth;
+			return depth;
+		}
+		// index pages under an entry of a directory page at a given level (1 being right above index pages)
+		static size_t implDirSpan( size_t depth )
+		{
+			size_t span = 1;
+			for ( size_t i=1; i<depth; ++i )
+				span *= maxAddressedByDirPage;
+			return span;
+		}
+		// adds the k-th index page of the directory; directory pages are added on the way as needed
+		void implDirAppend( size_t k, PagePointer indexPage )
+		{
+			if ( k == 0 )
+			{
+				dirRoot = indexPage;
+				return;
+			}
+			size_t depth = implDirDepth( k + 1 );
+			if ( depth > implDirDepth( k ) ) // the tree is full; its root becomes the first entry of a new one
+			{
+				PagePointer root = implAcquirePageWrapper();
+				implDirEntries( root )[0] = dirRoot;
+				dirRoot = root;
+			}
+			PagePointer* entries = implDirEntries( dirRoot );
+			for ( size_t span = implDirSpan( depth ); span > 1; span /= maxAddressedByDirPage )
+			{
+				size_t i = k / span;
+				k %= span;
+				if ( k == 0 ) // the first index page under this entry
+					entries[i] = implAcquirePageWrapper();
+				entries = implDirEntries( entries[i] );
+			}
+			entries[k] = indexPage;
+		}
+		const IndexPageHeader* implDirIndexPage( size_t k ) const
+		{
+			size_t depth = implDirDepth( implDirIndexPageCnt( pageCnt ) );
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, k < implDirIndexPageCnt( pageCnt ), "{} vs. {}", k, implDirIndexPageCnt( pageCnt ) );
+			PagePointer p = dirRoot;
+			if ( depth != 0 )
+			{
+				for ( size_t span = implDirSpan( depth ); span != 0; span /= maxAddressedByDirPage )
+				{
+					p = implDirEntries( p )[k / span];
+					k %= span;
+				}
+			}
+			return reinterpret_cast<const IndexPageHeader*>( p.page() );
+		}
+		// releases directory pages (but not index pages, which are released with the list) under dirPage, with indexPageCnt index pages under it
+		void implDirRelease( PagePointer dirPage, size_t depth, size_t indexPageCnt )
+		{
+			if ( depth == 0 )
+				return;
+			size_t span = implDirSpan( depth );
+			for ( size_t i=0; i*span<indexPageCnt; ++i )
+				implDirRelease( implDirEntries( dirPage )[i], depth - 1, indexPageCnt - i*span < span ? indexPageCnt - i*span : span );
+			implReleasePageWrapper( dirPage );
+		}
+
 		void implReleaseAllPages()
 		{
-			size_t i;
-			for ( i=0; i<localStorageSize && i<pageCnt; ++i )
+			size_t dirIndexPageCnt = implDirIndexPageCnt( pageCnt );
+			if ( dirIndexPageCnt != 0 )
+				implDirRelease( dirRoot, implDirDepth( dirIndexPageCnt ), dirIndexPageCnt );
+			dirRoot.init();
+			size_t i = 0;
+			if constexpr ( PageProvider::cellSize != 0 )
+			{
+				if ( cellSz != 0 )
+				{
+					NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, pageCnt == 1 );
+					PageProvider::releaseCell( firstHeader.firstPages[0] );
+					i = 1;
+				}
+			}
+			for ( ; i<localStorageSize && i<pageCnt; ++i )
 				implReleasePageWrapper( firstHeader.firstPages[i] );
 			pageCnt -= i;
 			if ( pageCnt )
 			{
 				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, firstHeader.next() != nullptr );
+				bool isFirst = true;
 				while ( firstHeader.next() != nullptr )
 				{
 					NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, pageCnt > localStorageSize || firstHeader.next()->next() == nullptr );
@@ -167,12 +356,17 @@ namespace nodecpp::platform::internal_msg {
 					pageCnt -= firstHeader.next()->usedCnt;
 					PagePointer page = firstHeader.next_;
 					firstHeader.next_ = firstHeader.next()->next_;
-					implReleasePageWrapper( page );
+					if ( isFirst )
+						implReleaseFirstIndexPage( page );
+					else
+						implReleasePageWrapper( page );
+					isFirst = false;
 				}
 			}
 		}
 
-		void implAddPage() // TODO: revise
+		void implAddPage() { implAddPage( implAcquirePageWrapper() ); }
+		void implAddPage( PagePointer page ) // TODO: revise
 		{
 			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, currentPage.page() == nullptr );
 			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, offsetInCurrentPage() == 0 );
@@ -180,87 +374,118 @@ namespace nodecpp::platform::internal_msg {
 			{
 				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, firstHeader.next() == nullptr );
 				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, lip.page() == nullptr );
-				firstHeader.firstPages[pageCnt] = implAcquirePageWrapper();
-				currentPage = firstHeader.firstPages[pageCnt];
+				firstHeader.firstPages[pageCnt] = page;
+				currentPage = page;
 				++(firstHeader.usedCnt);
 			}
 			else if ( lastIndexPage() == nullptr )
 			{
 				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, firstHeader.next() == nullptr );
-				lip = implAcquirePageWrapper();
+				lip = implAcquireFirstIndexPage();
 				firstHeader.setNext(lip);
-				currentPage = implAcquirePageWrapper();
+				currentPage = page;
 				lastIndexPage()->init( currentPage );
 //				lip = currentPage;
 			}
-			else if ( lastIndexPage()->usedCnt == maxAddressedByPage )
+			else if ( lastIndexPage()->usedCnt == ( lastIndexPage() == firstHeader.next() ? maxAddressedByFirstIndexPage : maxAddressedByPage ) )
 			{
 				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, firstHeader.next() != nullptr );
 				PagePointer nextip_ = implAcquirePageWrapper();
 				IndexPageHeader* nextip = reinterpret_cast<IndexPageHeader*>(nextip_.page());
-				currentPage = implAcquirePageWrapper();
+				currentPage = page;
 				nextip->init( currentPage );
 				lastIndexPage()->next_ = nextip_;
 				lip = nextip_;
+				implDirAppend( implDirIndexPageCnt( pageCnt ), nextip_ );
 			}
 			else
 			{
 				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, firstHeader.next() != nullptr );
-				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, lastIndexPage()->usedCnt < maxAddressedByPage );
-				currentPage = implAcquirePageWrapper();
+				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, lastIndexPage()->usedCnt < ( lastIndexPage() == firstHeader.next() ? maxAddressedByFirstIndexPage : maxAddressedByPage ) );
+				currentPage = page;
 				lastIndexPage()->pages()[lastIndexPage()->usedCnt] = currentPage;
 				++(lastIndexPage()->usedCnt);
 			}
 			++pageCnt;
 		}
 
+		// moves a message that no longer fits its cell to a page
+		void implPromoteCell()
+		{
+			if constexpr ( PageProvider::cellSize != 0 )
+			{
+				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, cellSz != 0 && pageCnt == 1 && totalSz < cellSz );
+				PagePointer page = implAcquirePageWrapper();
+				memcpy( page.page(), firstHeader.firstPages[0].page(), totalSz );
+				PageProvider::releaseCell( firstHeader.firstPages[0] );
+				firstHeader.firstPages[0] = page;
+				currentPage = page;
+				cellSz = 0;
+			}
+		}
+
 	public:
 		static constexpr size_t app_reserved = 8 * sizeof( void* );
-		static constexpr size_t total_reserved = app_reserved + sizeof(FirstHeader) + 2 * sizeof( PagePointer ) + 2 * sizeof( size_t );
+		static constexpr size_t total_reserved = app_reserved + sizeof( void* ) + sizeof(FirstHeader) + 3 * sizeof( PagePointer ) + 3 * sizeof( size_t );
+		static_assert( PageProvider::cellSize == 0 || ( PageProvider::cellSize > total_reserved && pageSize % PageProvider::cellSize == 0 ) );
 
 	public:
 		class ReadIter
 		{
-			friend class InternalMsg;
+			friend class InternalMsgImpl;
 			const IndexPageHeader* ip;
+			const PagePointer* slot; // of the current page in ip
+			const PagePointer* slotsEnd; // of ip, as known when the iterator is created (data it is to read is within)
 			const uint8_t* page;
 			size_t totalSz;
 			size_t sizeRemainingInBlock;
-			size_t idxInIndexPage;
 			size_t currentOffset = 0;
 
+			// a page transition reads the next slot only; index pages are hopped over once per their usedCnt pages
+			void implNextPage()
+			{
+				if ( ++slot == slotsEnd )
+				{
+					ip = ip->next();
+					slot = ip->pages();
+					slotsEnd = slot + ip->usedCnt;
+				}
+				page = slot->page();
+				sizeRemainingInBlock = totalSz <= pageSize ? totalSz : pageSize;
+			}
+
 		public:
-			using BufferT = InternalMsg;
+			using BufferT = InternalMsgImpl;
 			using CharT = char;
 
-			ReadIter( const IndexPageHeader* ip_, const uint8_t* page_, size_t sz ) : ip( ip_ ), page( page_ ), totalSz( sz )
+			ReadIter( const IndexPageHeader* ip_, const uint8_t* page_, size_t sz ) : ip( ip_ ), slot( ip_->pages() ), slotsEnd( ip_->pages() + ip_->usedCnt ), page( page_ ), totalSz( sz )
 			{
 //				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, sz >= total_reserved );
 				sizeRemainingInBlock = sz <= pageSize - total_reserved ? sz : pageSize - total_reserved;
 //				sizeRemainingInBlock = sz <= pageSize ? sz : pageSize;
-				idxInIndexPage = 0;
 			}
+			// positioned within a page other than the first one (see InternalMsgImpl::getReadIter( size_t offset ))
+			ReadIter( const IndexPageHeader* ip_, size_t idxInIndexPage_, size_t offsetInPage, size_t sz, size_t offset ) : 
+				ip( ip_ ), slot( ip_->pages() + idxInIndexPage_ ), slotsEnd( ip_->pages() + ip_->usedCnt ), page( slot->page() + offsetInPage ), totalSz( sz ), currentOffset( offset )
+			{
+				sizeRemainingInBlock = sz <= pageSize - offsetInPage ? sz : pageSize - offsetInPage;
+			}
+			// over contiguous data (say, a memory-mapped file, see MappedFile): a single block, with no pages behind it
+			ReadIter( const uint8_t* data, size_t sz ) : ip( nullptr ), slot( nullptr ), slotsEnd( nullptr ), page( data ), totalSz( sz ), sizeRemainingInBlock( sz ) {}
 			void impl_skip( size_t sz )
 			{
 				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, sz <= sizeRemainingInBlock );
-				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, ip != nullptr );
+				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, ip != nullptr || sizeRemainingInBlock == totalSz );
 				sizeRemainingInBlock -= sz;
 				totalSz -= sz;
 				if ( totalSz && sizeRemainingInBlock == 0 )
-				{
-					if ( idxInIndexPage + 1 >= ip->usedCnt )
-					{
-						ip = ip->next();
-						idxInIndexPage = 0;
-						page = ip->pages()[idxInIndexPage].page();
-					}
-					else
-						page = ip->pages()[++idxInIndexPage].page();
-					sizeRemainingInBlock = totalSz <= pageSize ? totalSz : pageSize;
-				}
+					implNextPage();
 				else
 					page += sz;
 			}
+			// at the beginning of a page that is full of data to be read
+			bool impl_isAtWholePage() const { return ip != nullptr && sizeRemainingInBlock == pageSize && page == slot->page(); }
+			PagePointer impl_currentPage() const { return *slot; }
 		public:
 			size_t directlyAvailableSize() const {return sizeRemainingInBlock;}
 			size_t totalAvailableSize() const {return totalSz;}
@@ -268,22 +493,12 @@ namespace nodecpp::platform::internal_msg {
 			const uint8_t* directRead( size_t sz )
 			{
 				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, sz <= sizeRemainingInBlock );
-				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, ip != nullptr );
+				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, ip != nullptr || sizeRemainingInBlock == totalSz );
 				sizeRemainingInBlock -= sz;
 				totalSz -= sz;
 				const uint8_t* ret = page;
 				if ( totalSz && sizeRemainingInBlock == 0 )
-				{
-					if ( idxInIndexPage + 1 >= ip->usedCnt )
-					{
-						ip = ip->next();
-						idxInIndexPage = 0;
-						page = ip->pages()[idxInIndexPage].page();
-					}
-					else
-						page = ip->pages()[++idxInIndexPage].page();
-					sizeRemainingInBlock = totalSz <= pageSize ? totalSz : pageSize;
-				}
+					implNextPage();
 				else
 					page += sz;
 				currentOffset += sz;
@@ -342,9 +557,100 @@ namespace nodecpp::platform::internal_msg {
 					}
 					asz = directlyAvailableSize();
 				}
-				currentOffset += size;
+				currentOffset += ret;
 				return ret;
 			}
+			// Typed readers: little-endian integers, LEB128 varints (zigzag-encoded for signed values), strings.
+			// Values within the current block are read in place; only those crossing a page boundary take a slower path.
+			// Data must be there (see totalAvailableSize())
+			template<class T>
+			T readLE()
+			{
+				static_assert( std::is_integral_v<T> );
+				T ret = 0;
+				if ( NODECPP_LIKELY( sizeof(T) < sizeRemainingInBlock ) )
+				{
+					memcpy( &ret, page, sizeof(T) );
+					page += sizeof(T);
+					sizeRemainingInBlock -= sizeof(T);
+					totalSz -= sizeof(T);
+					currentOffset += sizeof(T);
+				}
+				else
+				{
+					NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, sizeof(T) <= totalSz, "{} vs. {}", sizeof(T), totalSz );
+					read( &ret, sizeof(T) );
+				}
+				return LEToNative( ret );
+			}
+			uint8_t readUint8() { return readLE<uint8_t>(); }
+			uint16_t readUint16() { return readLE<uint16_t>(); }
+			uint32_t readUint32() { return readLE<uint32_t>(); }
+			uint64_t readUint64() { return readLE<uint64_t>(); }
+
+			uint64_t readVarUint()
+			{
+				uint64_t ret = 0;
+				if ( NODECPP_LIKELY( maxVarUintSize < sizeRemainingInBlock ) )
+				{
+					size_t i = 0;
+					for ( ;; ++i )
+					{
+						NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, i < maxVarUintSize );
+						uint8_t b = page[i];
+						ret |= (uint64_t)( b & 0x7f ) << ( 7 * i );
+						if ( ( b & 0x80 ) == 0 )
+							break;
+					}
+					++i;
+					page += i;
+					sizeRemainingInBlock -= i;
+					totalSz -= i;
+					currentOffset += i;
+					return ret;
+				}
+				for ( size_t i=0; ; ++i )
+				{
+					NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, i < maxVarUintSize && totalSz != 0 );
+					uint8_t b = (uint8_t)readChar();
+					ret |= (uint64_t)( b & 0x7f ) << ( 7 * i );
+					if ( ( b & 0x80 ) == 0 )
+						return ret;
+				}
+			}
+			int64_t readVarInt()
+			{
+				uint64_t v = readVarUint();
+				return (int64_t)( v >> 1 ) ^ -(int64_t)( v & 1 );
+			}
+
+			// points right into a page if the string is there as a whole; otherwise, it is copied to buff
+			std::string_view readString( size_t sz, std::string& buff )
+			{
+				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, sz <= totalSz, "{} vs. {}", sz, totalSz );
+				if ( NODECPP_LIKELY( sz <= sizeRemainingInBlock ) )
+					return std::string_view( reinterpret_cast<const char*>( directRead( sz ) ), sz );
+				buff.resize( sz );
+				read( buff.data(), sz );
+				return std::string_view( buff.data(), sz );
+			}
+			std::string_view readLengthPrefixedString( std::string& buff ) { return readString( readVarUint(), buff ); }
+
+			// describes up to maxCnt blocks of data from the current position on (the iterator is not moved; 
+			// when some of that data is written, skip() it); returns the number of entries filled
+			size_t gather( IoVec* vecs, size_t maxCnt ) const
+			{
+				ReadIter it = *this;
+				size_t cnt = 0;
+				while ( cnt < maxCnt && it.directlyAvailableSize() )
+				{
+					size_t sz = it.directlyAvailableSize();
+					vecs[cnt].iov_base = const_cast<uint8_t*>( it.directRead( sz ) );
+					vecs[cnt].iov_len = sz;
+					++cnt;
+				}
+				return cnt;
+			}
 			size_t offset() const { return currentOffset; }
 			CharT readChar()
 			{
@@ -368,10 +674,115 @@ namespace nodecpp::platform::internal_msg {
 				return ReadIter( &firstHeader, nullptr, 0 );
 		}
 
-		void reserveSpaceForConvertionToTag()
+		// Random access. Index page and position in it of a page with data at a given offset are computed right away; 
+		// an index page beyond the first linked one is then found in the directory (see dirRoot) in a hop per its level, 
+		// that is, in O(log n) hops with a base of maxAddressedByDirPage
+		void implLocatePage( size_t idx, const IndexPageHeader*& ip, size_t& idxInIndexPage ) const
+		{
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, idx < pageCnt, "{} vs. {}", idx, pageCnt );
+			if ( idx < localStorageSize )
+			{
+				ip = &firstHeader;
+				idxInIndexPage = idx;
+				return;
+			}
+			idx -= localStorageSize;
+			if ( idx < maxAddressedByFirstIndexPage )
+			{
+				ip = firstHeader.next();
+				idxInIndexPage = idx;
+				return;
+			}
+			idx -= maxAddressedByFirstIndexPage;
+			ip = implDirIndexPage( idx / maxAddressedByPage );
+			idxInIndexPage = idx % maxAddressedByPage;
+		}
+
+		ReadIter getReadIter( size_t offset ) const
+		{
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, offset <= size(), "{} vs. {}", offset, size() );
+			if ( offset == size() )
+			{
+				ReadIter it( &firstHeader, nullptr, 0 );
+				it.currentOffset = offset;
+				return it;
+			}
+			size_t pos = offset + total_reserved;
+			if ( pos < pageSize )
+			{
+				ReadIter it = getReadIter();
+				it.impl_skip( offset );
+				it.currentOffset = offset;
+				return it;
+			}
+			const IndexPageHeader* ip;
+			size_t idxInIndexPage;
+			implLocatePage( pos / pageSize, ip, idxInIndexPage );
+			return ReadIter( ip, idxInIndexPage, pos % pageSize, size() - offset, offset );
+		}
+
+		// overwrites data at a given offset (say, a length field in a header written before the body); 
+		// a shared page (see append( ReadIter, size_t )) is replaced by a private copy first. Invalidates iterators
+		void patch( size_t offset, const void* data, size_t sz )
+		{
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, offset + sz <= size(), "{} + {} vs. {}", offset, sz, size() );
+			const uint8_t* src = reinterpret_cast<const uint8_t*>( data );
+			if ( sz == 0 )
+				return;
+			size_t pos = offset + total_reserved;
+			const IndexPageHeader* ip;
+			size_t idxInIndexPage;
+			implLocatePage( pos / pageSize, ip, idxInIndexPage ); // further pages follow in the list
+			while ( sz != 0 )
+			{
+				PagePointer& slot = const_cast<IndexPageHeader*>( ip )->pages()[idxInIndexPage];
+				if constexpr ( PageProvider::canSharePages )
+				{
+					if ( cellSz == 0 && PageProvider::isPageShared( slot ) )
+					{
+						PagePointer copy = implAcquirePageWrapper();
+						memcpy( copy.page(), slot.page(), pageSize );
+						implReleasePageWrapper( slot );
+						slot = copy;
+					}
+				}
+				size_t offsetInPage = pos % pageSize;
+				size_t chunk = sz < pageSize - offsetInPage ? sz : pageSize - offsetInPage;
+				memcpy( slot.page() + offsetInPage, src, chunk );
+				src += chunk;
+				pos += chunk;
+				sz -= chunk;
+				if ( sz != 0 && ++idxInIndexPage == ip->usedCnt )
+				{
+					ip = ip->next();
+					idxInIndexPage = 0;
+				}
+			}
+		}
+		template<class T>
+		void patchLE( size_t offset, T val )
+		{
+			static_assert( std::is_integral_v<T> );
+			T v = nativeToLE( val );
+			patch( offset, &v, sizeof(T) );
+		}
+
+		// a message that is expected to stay small (that is, to take less than a cell with expectedSz bytes of data) starts in a cell
+		void reserveSpaceForConvertionToTag( size_t expectedSz = pageSize )
 		{
 			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, currentPage.page() == nullptr );
-			implAddPage();
+			if constexpr ( PageProvider::cellSize != 0 )
+			{
+				if ( expectedSz < PageProvider::cellSize - total_reserved )
+				{
+					implAddPage( PageProvider::acquireCell() );
+					cellSz = PageProvider::cellSize;
+				}
+				else
+					implAddPage();
+			}
+			else
+				implAddPage();
 			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, currentPage.page() != nullptr );
 			size_t remainingInPage = remainingSizeInCurrentPage();
 			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, total_reserved < remainingInPage, "{} vs. {}", total_reserved, remainingInPage );
@@ -382,32 +793,37 @@ namespace nodecpp::platform::internal_msg {
 		{
 			implReleaseAllPages();
 			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, pageCnt == 0 );
-			firstHeader.next_.init();
+			firstHeader.init(); // usedCnt, too: a message may be filled again
 			lip.init();
 			currentPage.init();
 			totalSz = 0;
+			cellSz = 0;
 		}
 
 	public:
-		InternalMsg() { 
+		InternalMsgImpl() { 
 			firstHeader.init(); 
 			memset( firstHeader.firstPages, 0, sizeof( firstHeader.firstPages ) );
 		}
-		InternalMsg( const InternalMsg& ) = delete;
-		InternalMsg& operator = ( const InternalMsg& ) = delete;
-		InternalMsg( InternalMsg&& other ) noexcept
+		InternalMsgImpl( const InternalMsgImpl& ) = delete;
+		InternalMsgImpl& operator = ( const InternalMsgImpl& ) = delete;
+		InternalMsgImpl( InternalMsgImpl&& other ) noexcept
 		{
 			firstHeader = std::move( other.firstHeader );
 			pageCnt = other.pageCnt;
 			other.pageCnt = 0;
 			lip = other.lip;
 			other.lip.init();
+			dirRoot = other.dirRoot;
+			other.dirRoot.init();
 			currentPage = other.currentPage;
 			other.currentPage.init();
 			totalSz = other.totalSz;
 			other.totalSz = 0;
+			cellSz = other.cellSz;
+			other.cellSz = 0;
 		}
-		InternalMsg& operator = ( InternalMsg&& other ) noexcept
+		InternalMsgImpl& operator = ( InternalMsgImpl&& other ) noexcept
 		{
 			if ( this == &other ) return *this;
 			impl_clear();
@@ -416,10 +832,14 @@ namespace nodecpp::platform::internal_msg {
 			other.pageCnt = 0;
 			lip = other.lip;
 			other.lip.init();
+			dirRoot = other.dirRoot;
+			other.dirRoot.init();
 			currentPage = other.currentPage;
 			other.currentPage.init();
 			totalSz = other.totalSz;
 			other.totalSz = 0;
+			cellSz = other.cellSz;
+			other.cellSz = 0;
 			return *this;
 		}
 		void appWriteData( void* data, size_t offset, size_t sz )
@@ -443,37 +863,81 @@ namespace nodecpp::platform::internal_msg {
 			const uint8_t* appPrefix = firstHeader.pages()[0].page() + total_reserved - app_reserved;
 			memcpy( data, appPrefix + offset, sz );
 		}
-		InternalMsg* convertToPointer()
+		InternalMsgImpl* convertToPointer()
 		{
+			// the object itself, the link slot (see linkOf()) and app_reserved data must fit into the reserved part of the first page
+			static_assert( sizeof( InternalMsgImpl ) + sizeof( void* ) + app_reserved <= total_reserved );
 			if ( totalSz )
 			{
 				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, firstHeader.pages()[0].page() != nullptr );
 				uint8_t* prefix = firstHeader.pages()[0].page();
-				memcpy( prefix, this, sizeof( InternalMsg ) );
-				memset( this, 0, sizeof( InternalMsg ) );
-				return (InternalMsg*)prefix;
+				memcpy( prefix, this, sizeof( InternalMsgImpl ) );
+				memset( this, 0, sizeof( InternalMsgImpl ) );
+				return (InternalMsgImpl*)prefix;
 			}
 			else
 			{
 				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, firstHeader.pages()[0].page() == nullptr );
-				return (InternalMsg*)nullptr;
+				return (InternalMsgImpl*)nullptr;
 			}
 		}
-		void restoreFromPointer(InternalMsg* ptr)
+		void restoreFromPointer(InternalMsgImpl* ptr)
 		{
+			static_assert( sizeof( InternalMsgImpl ) + sizeof( void* ) + app_reserved <= total_reserved );
 			impl_clear();
 			if ( ptr != nullptr )
 			{
-				memcpy( this, ptr, sizeof( InternalMsg ) );
+				memcpy( this, ptr, sizeof( InternalMsgImpl ) );
 			}
 		}
+		// a slot right before the app_reserved area of a converted message, for its current holder to link it into a list (see InternalMsgQueueImpl)
+		static InternalMsgImpl*& linkOf( InternalMsgImpl* converted )
+		{
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, converted != nullptr );
+			return *reinterpret_cast<InternalMsgImpl**>( reinterpret_cast<uint8_t*>( converted ) + total_reserved - app_reserved - sizeof( void* ) );
+		}
+
+		// A message with the same data and app_reserved data. If pages can be shared, the clone shares all full pages but the first one 
+		// (which holds the header of a message) with this message, and copies the first page and the partially filled last one, so that 
+		// fan-out of a message costs a reference count per page rather than a copy of data; either message may then be appended to, or 
+		// patched (which copies a shared page first), independently. Otherwise, it is a copy
+		InternalMsgImpl clone() const
+		{
+			InternalMsgImpl ret;
+			if ( totalSz == 0 )
+				return ret;
+			ret.reserveSpaceForConvertionToTag( cellSz != 0 ? size() : pageSize );
+			const uint8_t* appPrefix = firstHeader.pages()[0].page() + total_reserved - app_reserved;
+			memcpy( ret.firstHeader.pages()[0].page() + total_reserved - app_reserved, appPrefix, app_reserved );
+			ret.append( getReadIter(), size() );
+			return ret;
+		}
 
+		// If pages can be shared, whole pages of the source are shared rather than copied wherever both messages are at a page boundary 
+		// (which is always the case when a whole message, or its part starting at the same offset, is appended to an empty one); 
+		// copying goes up to a page boundary of this message to keep such a chance. Shared pages are full and are never written to
 		void append(ReadIter it, size_t sz)
 		{
 			size_t pending = (it.totalAvailableSize() < sz) ? it.totalAvailableSize() : sz;
 			while (pending != 0)
 			{
 				size_t currentSz = (it.directlyAvailableSize() < pending) ? it.directlyAvailableSize() : pending;
+				if constexpr ( PageProvider::canSharePages )
+				{
+					if ( totalSz != 0 && currentPage.page() == nullptr && pending >= pageSize && it.impl_isAtWholePage() )
+					{
+						PagePointer page = it.impl_currentPage();
+						PageProvider::sharePage( page );
+						implAddPage( page );
+						currentPage.init();
+						totalSz += pageSize;
+						it.impl_skip( pageSize );
+						pending -= pageSize;
+						continue;
+					}
+					if ( currentPage.page() != nullptr && currentSz > remainingSizeInCurrentPage() )
+						currentSz = remainingSizeInCurrentPage();
+				}
 				const uint8_t* ptr = it.directRead(currentSz);
 				append(ptr, currentSz);
 
@@ -493,10 +957,12 @@ namespace nodecpp::platform::internal_msg {
 					else
 					{
 						NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, currentPage.page() == nullptr );
-						reserveSpaceForConvertionToTag();
+						reserveSpaceForConvertionToTag( sz );
 					}
 					NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, currentPage.page() != nullptr );
 				}
+				if ( cellSz != 0 && sz >= remainingSizeInCurrentPage() )
+					implPromoteCell();
 				size_t remainingInPage = remainingSizeInCurrentPage();
 				if ( sz <= remainingInPage )
 				{
@@ -520,6 +986,17 @@ namespace nodecpp::platform::internal_msg {
 				}
 			}
 		}
+		void implAppendSmall( const void* data, size_t sz )
+		{
+			if ( NODECPP_LIKELY( currentPage.page() != nullptr && sz < remainingSizeInCurrentPage() ) )
+			{
+				memcpy( currentPage.page() + offsetInCurrentPage(), data, sz );
+				totalSz += sz;
+			}
+			else
+				append( data, sz );
+		}
+
 		void appendUint8( uint8_t what )
 		{
 			if ( currentPage.page() == nullptr )
@@ -529,10 +1006,12 @@ namespace nodecpp::platform::internal_msg {
 				else
 				{
 					NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, currentPage.page() == nullptr );
-					reserveSpaceForConvertionToTag();
+					reserveSpaceForConvertionToTag( 1 );
 				}
 				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, currentPage.page() != nullptr );
 			}
+			if ( cellSz != 0 && 1 == remainingSizeInCurrentPage() )
+				implPromoteCell();
 			size_t remainingInPage = remainingSizeInCurrentPage();
 			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, remainingInPage != 0 );
 			*(currentPage.page() + offsetInCurrentPage()) = what;
@@ -544,6 +1023,191 @@ namespace nodecpp::platform::internal_msg {
 			}
 		}
 
+		// Typed appenders, counterparts of typed readers of ReadIter
+		template<class T>
+		void appendLE( T val )
+		{
+			static_assert( std::is_integral_v<T> );
+			T v = nativeToLE( val );
+			implAppendSmall( &v, sizeof(T) );
+		}
+		void appendUint16( uint16_t val ) { appendLE( val ); }
+		void appendUint32( uint32_t val ) { appendLE( val ); }
+		void appendUint64( uint64_t val ) { appendLE( val ); }
+
+		void appendVarUint( uint64_t val )
+		{
+			uint8_t buff[maxVarUintSize];
+			size_t sz = 0;
+			while ( val >= 0x80 )
+			{
+				buff[sz++] = (uint8_t)( val | 0x80 );
+				val >>= 7;
+			}
+			buff[sz++] = (uint8_t)val;
+			implAppendSmall( buff, sz );
+		}
+		void appendVarInt( int64_t val ) { appendVarUint( ( (uint64_t)val << 1 ) ^ (uint64_t)( val >> 63 ) ); }
+
+		void appendLengthPrefixedString( std::string_view str )
+		{
+			appendVarUint( str.size() );
+			append( str.data(), str.size() );
+		}
+
+		// Cursor-style writer for filling a message by small pieces: it keeps the current write position and the end of the current page, 
+		// and goes to the message only when a piece does not fit into the rest of the page (and when flushed). 
+		// The message must not be used otherwise until flush() (or destruction of the writer); the last byte of a page (or a cell) 
+		// is written by the slow path, as in append()
+		class Writer
+		{
+			// slow paths take and return positions by value, for a writer never to be addressed; otherwise, its positions 
+			// would be reloaded after each byte written (which might alias them)
+			struct Cursor
+			{
+				uint8_t* pos;
+				uint8_t* end;
+			};
+			static Cursor implCursor( InternalMsgImpl& msg )
+			{
+				if ( msg.currentPage.page() != nullptr )
+				{
+					uint8_t* page = msg.currentPage.page();
+					return { page + msg.offsetInCurrentPage(), page + ( msg.cellSz ? msg.cellSz : pageSize ) };
+				}
+				return { nullptr, nullptr };
+			}
+			NODECPP_NOINLINE static Cursor implWriteSlow( InternalMsgImpl& msg, size_t written, const void* data, size_t sz )
+			{
+				msg.totalSz += written;
+				msg.append( data, sz );
+				return implCursor( msg );
+			}
+			NODECPP_NOINLINE static Cursor implWriteVarUintSlow( InternalMsgImpl& msg, size_t written, uint64_t val )
+			{
+				msg.totalSz += written;
+				msg.appendVarUint( val );
+				return implCursor( msg );
+			}
+
+			InternalMsgImpl& msg;
+			uint8_t* pos;
+			uint8_t* end;
+			uint8_t* committed; // up to here, data is accounted in msg.totalSz
+
+			void implSet( Cursor c ) { pos = committed = c.pos; end = c.end; }
+
+		public:
+			explicit Writer( InternalMsgImpl& msg_ ) : msg( msg_ ) { implSet( implCursor( msg ) ); }
+			Writer( const Writer& ) = delete;
+			Writer& operator = ( const Writer& ) = delete;
+			~Writer() { flush(); }
+
+			void write( const void* data, size_t sz )
+			{
+				if ( NODECPP_LIKELY( sz < (size_t)( end - pos ) ) )
+				{
+					memcpy( pos, data, sz );
+					pos += sz;
+				}
+				else
+					implSet( implWriteSlow( msg, pos - committed, data, sz ) );
+			}
+			void writeUint8( uint8_t what )
+			{
+				if ( NODECPP_LIKELY( end - pos > 1 ) )
+					*pos++ = what;
+				else
+					implSet( implWriteSlow( msg, pos - committed, &what, 1 ) );
+			}
+			template<class T>
+			void writeLE( T val )
+			{
+				static_assert( std::is_integral_v<T> );
+				T v = nativeToLE( val );
+				write( &v, sizeof(T) );
+			}
+			void writeVarUint( uint64_t val )
+			{
+				if ( NODECPP_LIKELY( maxVarUintSize < (size_t)( end - pos ) ) )
+				{
+					while ( val >= 0x80 )
+					{
+						*pos++ = (uint8_t)( val | 0x80 );
+						val >>= 7;
+					}
+					*pos++ = (uint8_t)val;
+				}
+				else
+					implSet( implWriteVarUintSlow( msg, pos - committed, val ) );
+			}
+
+			// makes data written so far a part of the message
+			void flush()
+			{
+				msg.totalSz += pos - committed;
+				committed = pos;
+			}
+		};
+
+		// Scatter receive: prepareReceive() describes up to maxCnt buffers right after the current end of the message 
+		// (the rest of the current page, if any, and then fresh pages); data is read into them directly (say, by readv()), 
+		// and commitReceive() is then called with the same buffers and the number of bytes actually received 
+		// to make them a part of the message (unused fresh pages are released). The message must not be modified in between
+		size_t prepareReceive( IoVec* vecs, size_t maxCnt )
+		{
+			if ( maxCnt == 0 )
+				return 0;
+			if ( totalSz == 0 )
+				reserveSpaceForConvertionToTag();
+			else if ( cellSz != 0 )
+				implPromoteCell();
+			size_t cnt = 0;
+			if ( currentPage.page() != nullptr )
+			{
+				vecs[0].iov_base = currentPage.page() + offsetInCurrentPage();
+				vecs[0].iov_len = remainingSizeInCurrentPage();
+				++cnt;
+			}
+			for ( ; cnt<maxCnt; ++cnt )
+			{
+				vecs[cnt].iov_base = implAcquirePageWrapper().page();
+				vecs[cnt].iov_len = pageSize;
+			}
+			return cnt;
+		}
+		void commitReceive( const IoVec* vecs, size_t cnt, size_t bytes )
+		{
+			size_t i = 0;
+			if ( cnt != 0 && currentPage.page() != nullptr )
+			{
+				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, vecs[0].iov_base == currentPage.page() + offsetInCurrentPage() );
+				size_t sz = bytes < vecs[0].iov_len ? bytes : vecs[0].iov_len;
+				totalSz += sz;
+				bytes -= sz;
+				if ( offsetInCurrentPage() == 0 )
+					currentPage.init();
+				++i;
+			}
+			for ( ; i<cnt; ++i )
+			{
+				PagePointer page( vecs[i].iov_base );
+				if ( bytes == 0 )
+				{
+					implReleasePageWrapper( page );
+					continue;
+				}
+				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, currentPage.page() == nullptr && vecs[i].iov_len == pageSize );
+				implAddPage( page );
+				size_t sz = bytes < pageSize ? bytes : pageSize;
+				totalSz += sz;
+				bytes -= sz;
+				if ( sz == pageSize )
+					currentPage.init();
+			}
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, bytes == 0 );
+		}
+
 		void clear() 
 		{
 			impl_clear();
@@ -553,9 +1217,9 @@ namespace nodecpp::platform::internal_msg {
 			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, totalSz == 0 || totalSz >= total_reserved, "{} vs. {}", totalSz, total_reserved );
 			return totalSz != 0 ? totalSz - total_reserved : 0;
 		}
-		~InternalMsg() { implReleaseAllPages(); }
+		~InternalMsgImpl() { implReleaseAllPages(); }
 	};
-	static_assert( sizeof( InternalMsg ) + InternalMsg::app_reserved <= InternalMsg::total_reserved );
+	using InternalMsg = InternalMsgImpl<PoolPageProvider>;
 
 } // nodecpp
 
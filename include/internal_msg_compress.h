@@ -0,0 +1,132 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef INTERNAL_MSG_COMPRESS_H
+#define INTERNAL_MSG_COMPRESS_H
+
+#include "internal_msg.h"
+#include <memory>
+
+namespace nodecpp::platform::internal_msg { 
+
+	// Compressed data is a standard LZ4 frame (as by the lz4 command line tool), or a zstd frame (as by zstd), 
+	// both produced and consumed by streaming APIs of the respective libraries (see 3rdparty/lz4, 3rdparty/zstd)
+	enum class CompressionMethod : uint8_t { lz4, zstd };
+
+	struct CompressionOptions
+	{
+		static constexpr size_t maxBlockSize = 0x400000;
+		CompressionMethod method = CompressionMethod::lz4;
+		// higher is better compressed and slower, 0 is the default of a library, and negative levels are faster yet;
+		// lz4: 3 and higher are LZ4 HC levels (up to 12); zstd: up to 22
+		int level = 0;
+		// lz4: a block size (rounded up to 64Kb, 256Kb, 1Mb, or 4Mb); zstd: a window size (rounded up to a power of 2, at least 1Kb);
+		// memory needed on both sides is a few times that, regardless of the size of data
+		size_t blockSize = 0x10000;
+		bool checksum = false; // of the whole of data, verified on decompression
+	};
+
+	namespace impl {
+		// to append output of a stream to a message of whatever type
+		using AppendFn = void (*)( void* msg, const uint8_t* data, size_t sz );
+
+		class CompressStream
+		{
+			CompressionMethod method;
+			void* ctx = nullptr;
+			AppendFn append;
+			void* msg;
+			size_t inChunk; // at most that much is given to a library at once, so that its output fits into 'out'
+			size_t outCapacity;
+			std::unique_ptr<uint8_t[]> out;
+
+		public:
+			CompressStream( const CompressionOptions& options, AppendFn append, void* msg );
+			CompressStream( const CompressStream& ) = delete;
+			CompressStream& operator = ( const CompressStream& ) = delete;
+			~CompressStream();
+			void update( const uint8_t* data, size_t sz );
+			void finish();
+		};
+
+		// malformed or truncated data, as well as a zstd window beyond maxBlockSize, is logged and reported by throwing nodecpp::error::bad_message
+		class DecompressStream
+		{
+			CompressionMethod method;
+			void* ctx = nullptr;
+			AppendFn append;
+			void* msg;
+			size_t expected = 1; // as the library tells, 0 at the end of a frame
+			size_t outCapacity;
+			std::unique_ptr<uint8_t[]> out;
+
+			[[noreturn]] void reportMalformed( const char* what );
+
+		public:
+			DecompressStream( CompressionMethod method, AppendFn append, void* msg );
+			DecompressStream( const DecompressStream& ) = delete;
+			DecompressStream& operator = ( const DecompressStream& ) = delete;
+			~DecompressStream();
+			void update( const uint8_t* data, size_t sz );
+			void finish();
+		};
+
+		// feeds sz bytes of it to a stream page by page, in place
+		template<class StreamT, class ReadIterT>
+		void feed( StreamT& stream, ReadIterT& it, size_t sz )
+		{
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, sz <= it.totalAvailableSize(), "{} vs. {}", sz, it.totalAvailableSize() );
+			while ( sz != 0 )
+			{
+				size_t chunk = it.directlyAvailableSize() < sz ? it.directlyAvailableSize() : sz;
+				stream.update( it.directRead( chunk ), chunk );
+				sz -= chunk;
+			}
+			stream.finish();
+		}
+	} // namespace impl
+
+	// Neither side ever has the whole of data in one piece: the source is given to a library page by page, 
+	// and its output is appended to dst as it goes
+	template<class MsgT, class ReadIterT>
+	void compress( ReadIterT it, size_t sz, MsgT& dst, const CompressionOptions& options = CompressionOptions() )
+	{
+		impl::CompressStream stream( options, []( void* msg, const uint8_t* data, size_t sz ) { static_cast<MsgT*>( msg )->append( data, sz ); }, &dst );
+		impl::feed( stream, it, sz );
+	}
+
+	// sz is the size of compressed data (one or more frames); if data is malformed, dst may have been appended a part of it
+	template<class MsgT, class ReadIterT>
+	void decompress( ReadIterT it, size_t sz, MsgT& dst, CompressionMethod method )
+	{
+		impl::DecompressStream stream( method, []( void* msg, const uint8_t* data, size_t sz ) { static_cast<MsgT*>( msg )->append( data, sz ); }, &dst );
+		impl::feed( stream, it, sz );
+	}
+
+} // namespace nodecpp::platform::internal_msg
+
+#endif // INTERNAL_MSG_COMPRESS_H
@@ -0,0 +1,116 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef INTERNAL_MSG_QUEUE_H
+#define INTERNAL_MSG_QUEUE_H
+
+#include "internal_msg.h"
+#include <atomic>
+
+namespace nodecpp::platform::internal_msg { 
+
+	// Multi-producer single-consumer queue of messages. Nodes are the messages themselves, converted to pointers 
+	// (see InternalMsgImpl::convertToPointer()) and linked through their link slots, so that neither push() nor pop() allocates.
+	//   - producers push to a lock-free stack (a CAS per message)
+	//   - the consumer takes the whole stack at once (a single exchange) and reverses it, so that messages come out 
+	//     in the order of pushing (for each producer); further messages are then served from the taken list without touching shared state
+	// An empty message is given a reserved prefix (in a cell, if available) to be converted, and comes out empty
+	template<class MsgT>
+	class InternalMsgQueueImpl
+	{
+		alignas(NODECPP_CACHE_LINE_SIZE) std::atomic<MsgT*> pushed = nullptr; // most recent first
+		alignas(NODECPP_CACHE_LINE_SIZE) MsgT* taken = nullptr; // by the consumer; oldest first
+
+		bool implTake()
+		{
+			MsgT* stack = pushed.exchange( nullptr, std::memory_order_acquire );
+			if ( stack == nullptr )
+				return false;
+			MsgT* reversed = nullptr;
+			while ( stack != nullptr )
+			{
+				MsgT* next = MsgT::linkOf( stack );
+				MsgT::linkOf( stack ) = reversed;
+				reversed = stack;
+				stack = next;
+			}
+			taken = reversed;
+			return true;
+		}
+
+	public:
+		InternalMsgQueueImpl() {}
+		InternalMsgQueueImpl( const InternalMsgQueueImpl& ) = delete;
+		InternalMsgQueueImpl& operator = ( const InternalMsgQueueImpl& ) = delete;
+		~InternalMsgQueueImpl()
+		{
+			MsgT msg;
+			while ( pop( msg ) )
+				msg.clear();
+		}
+
+		// by any thread; msg is left empty
+		void push( MsgT& msg )
+		{
+			MsgT* ptr = msg.convertToPointer();
+			if ( ptr == nullptr )
+			{
+				msg.reserveSpaceForConvertionToTag( 0 );
+				ptr = msg.convertToPointer();
+			}
+			MsgT*& link = MsgT::linkOf( ptr );
+			link = pushed.load( std::memory_order_relaxed );
+			while ( !pushed.compare_exchange_weak( link, ptr, std::memory_order_release, std::memory_order_relaxed ) );
+		}
+
+		// by the consumer only
+		bool pop( MsgT& msg )
+		{
+			if ( taken == nullptr && !implTake() )
+				return false;
+			MsgT* ptr = taken;
+			taken = MsgT::linkOf( ptr );
+			msg.restoreFromPointer( ptr );
+			return true;
+		}
+		// up to maxCnt messages, oldest first; returns the number of them
+		size_t popBatch( MsgT* msgs, size_t maxCnt )
+		{
+			size_t cnt = 0;
+			while ( cnt < maxCnt && pop( msgs[cnt] ) )
+				++cnt;
+			return cnt;
+		}
+		// by the consumer only; there might be messages being pushed right now anyway
+		bool empty() const { return taken == nullptr && pushed.load( std::memory_order_relaxed ) == nullptr; }
+	};
+
+	using InternalMsgQueue = InternalMsgQueueImpl<InternalMsg>;
+
+} // nodecpp
+
+#endif // INTERNAL_MSG_QUEUE_H
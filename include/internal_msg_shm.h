@@ -0,0 +1,98 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef INTERNAL_MSG_SHM_H
+#define INTERNAL_MSG_SHM_H
+
+#include "internal_msg.h"
+#include "shm_page_pool.h"
+
+namespace nodecpp::platform::internal_msg { 
+
+	// a reference to a page of ShmPagePool: an offset within the region, valid in any process that has it mapped
+	struct ShmPagePtrWrapper
+	{
+	private:
+		uint64_t offset;
+	public:
+		ShmPagePtrWrapper() {init();}
+		ShmPagePtrWrapper( void* page ) {init( page );}
+		uint8_t* page() { return reinterpret_cast<uint8_t*>( ShmPagePool::fromOffset( offset ) ); }
+		const uint8_t* page() const { return reinterpret_cast<const uint8_t*>( ShmPagePool::fromOffset( offset ) ); }
+		void init() {offset = 0;}
+		void init( void* page ) {offset = ShmPagePool::toOffset( page ); }
+	};
+
+	class ShmPageProvider // pages are not shared between messages, and there are no cells
+	{
+	public:
+		using PagePointer = ShmPagePtrWrapper;
+		static constexpr size_t pageSize = ShmPagePool::pageSize;
+		static constexpr bool canSharePages = false;
+		static constexpr size_t cellSize = 0;
+		static PagePointer acquirePage() { return PagePointer( ShmPagePool::acquirePage() ); }
+		static void releasePage( PagePointer page ) { ShmPagePool::releasePage( page.page() ); }
+	};
+
+	using ShmInternalMsg = InternalMsgImpl<ShmPageProvider>;
+
+	// Passes messages to another process through a ring of ShmPagePool (a channel per direction; a single producer and a single consumer): 
+	// a message is converted to a pointer (see InternalMsgImpl::convertToPointer()) and its offset is passed; payload pages are not copied.
+	// An empty message is given a reserved prefix to be converted, and comes out empty
+	class ShmMsgChannel
+	{
+		size_t ringIdx;
+
+	public:
+		explicit ShmMsgChannel( size_t ringIdx_ ) : ringIdx( ringIdx_ ) {}
+
+		bool push( ShmInternalMsg& msg ) // msg is left empty, unless the ring is full
+		{
+			ShmInternalMsg* ptr = msg.convertToPointer();
+			if ( ptr == nullptr )
+			{
+				msg.reserveSpaceForConvertionToTag( 0 );
+				ptr = msg.convertToPointer();
+			}
+			if ( ShmPagePool::ring( ringIdx ).push( ShmPagePool::toOffset( ptr ) ) )
+				return true;
+			msg.restoreFromPointer( ptr );
+			return false;
+		}
+		bool pop( ShmInternalMsg& msg )
+		{
+			uint64_t offset;
+			if ( !ShmPagePool::ring( ringIdx ).pop( offset ) )
+				return false;
+			msg.restoreFromPointer( reinterpret_cast<ShmInternalMsg*>( ShmPagePool::fromOffset( offset ) ) );
+			return true;
+		}
+	};
+
+} // nodecpp
+
+#endif // INTERNAL_MSG_SHM_H
@@ -36,6 +36,7 @@
 #include <condition_variable>
 #include <vector>
 #include "page_allocator.h"
+#include "page_cache.h"
 
 
 namespace nodecpp::logging_impl {
@@ -111,32 +112,42 @@ namespace nodecpp::log {
 
 	struct LogBufferBaseData
 	{
+		// NOTE: fields are grouped by cache lines according to who writes them: 
+		//       read-mostly settings, the lock itself, logging threads (producers), and a writing thread (consumer).
+		//       This keeps the writer's unlocked reads of buff/buffSize/target and the contended mutex
+		//       from being invalidated each time a producer moves 'end'
+
 		static constexpr size_t maxMessageSize = 0x1000;
-		LogLevel levelCouldBeSkipped = LogLevel::info;
+		static constexpr size_t pageCount = 4; // so far it is not obvious why we really need something else
+		static constexpr size_t skippedCntMsgSz = 128; // an upper estimation for quick calculations
+
+		// read-mostly data
+		alignas(NODECPP_CACHE_LINE_SIZE) LogLevel levelCouldBeSkipped = LogLevel::info;
 		LogLevel levelGuaranteedWrite = LogLevel::fatal;
 		size_t pageSize = 0; // consider making a constexpr (do we consider 2Mb pages?)
-		static constexpr size_t pageCount = 4; // so far it is not obvious why we really need something else
 		uint8_t* buff = nullptr; // aming: a set of consequtive pages
 		size_t buffSize = 0; // a multiple of page size
-		uint64_t start = 0; // mx-protected; writable by a thread writing to a file; readable: all
-		uint64_t writerPromisedNextStart = 0; // mx-protected; writable: writing thread; readable: all
-		uint64_t end = 0; // mx-protected; writable: logging threads, writing thread(in case of periodic flushing); readable: all
-		uint64_t mustBeWrittenImmediately = 0; // mx-protected; writable: logging threads, writing thread(in case of periodic flushing); readable: all
-		static constexpr size_t skippedCntMsgSz = 128; // an upper estimation for quick calculations
-		SkippedMsgCounters skippedCtrs; // mx-protected; accessible by log-writing threads
+		enum class Action { proceed = 0, proceedToTermination, terminationAllowed };
+		Action action = Action::proceed; // mx-protected; changes once or twice per lifetime
+		size_t refCounter = 0; // mx-protected; changes only when transports are added or removed
+		FILE* target = nullptr; // so far...
+
+		// synchronization
+		alignas(NODECPP_CACHE_LINE_SIZE) std::mutex mx;
 		std::condition_variable waitWriter;
-		size_t refCounter = 0; // mx-protected
-		std::mutex mx;
 
-		ChainedWaitingData* firstToRelease = nullptr; // for writer
+		// written by logging threads
+		alignas(NODECPP_CACHE_LINE_SIZE) uint64_t end = 0; // mx-protected; writable: logging threads, writing thread(in case of periodic flushing); readable: all
+		uint64_t mustBeWrittenImmediately = 0; // mx-protected; writable: logging threads, writing thread(in case of periodic flushing); readable: all
+		SkippedMsgCounters skippedCtrs; // mx-protected; accessible by log-writing threads
 		ChainedWaitingData* nextToAdd = nullptr; // for loggers
-		ChainedWaitingForGuaranteedWrite* firstToReleaseGuaranteed = nullptr; // for writer
 		ChainedWaitingForGuaranteedWrite* nextToAddGuaranteed = nullptr; // for loggers
 
-		enum class Action { proceed = 0, proceedToTermination, terminationAllowed };
-		Action action = Action::proceed;
-
-		FILE* target = nullptr; // so far...
+		// written by a writing thread
+		alignas(NODECPP_CACHE_LINE_SIZE) uint64_t start = 0; // mx-protected; writable by a thread writing to a file; readable: all
+		uint64_t writerPromisedNextStart = 0; // mx-protected; writable: writing thread; readable: all
+		ChainedWaitingData* firstToRelease = nullptr; // for writer
+		ChainedWaitingForGuaranteedWrite* firstToReleaseGuaranteed = nullptr; // for writer
 
 		void init( FILE* f );
 		void init( const char* path )
@@ -150,7 +161,7 @@ namespace nodecpp::log {
 			// TODO: revise (it seems to be the most reasonable to finalize destruction in writer thread
 			if ( buff )
 			{
-				::nodecpp::VirtualMemory::deallocate( buff, buffSize );
+				::nodecpp::PageCache::release( buff, buffSize / ::nodecpp::VirtualMemory::getPageSize(), ::nodecpp::MemoryTag::log );
 				buff = nullptr;
 			}
 			if ( target ) 
@@ -353,8 +364,7 @@ namespace nodecpp::log {
 		template<class StringT>
 		bool add( StringT path ) 
 		{
-			LogBufferBaseData* data = reinterpret_cast<LogBufferBaseData*>( malloc( sizeof(LogBufferBaseData) ) );
-			new (data) LogBufferBaseData();
+			LogBufferBaseData* data = new LogBufferBaseData(); // Note: over-aligned (see LogBufferBaseData)
 			data->init( path.c_str() );
 			data->levelCouldBeSkipped = levelCouldBeSkipped;
 			transports.emplace_back( data ); 
@@ -364,8 +374,7 @@ namespace nodecpp::log {
 
 		bool add( FILE* cons ) // TODO: input param is a subject for revision
 		{
-			LogBufferBaseData* data = reinterpret_cast<LogBufferBaseData*>( malloc( sizeof(LogBufferBaseData) ) );
-			new (data) LogBufferBaseData();
+			LogBufferBaseData* data = new LogBufferBaseData(); // Note: over-aligned (see LogBufferBaseData)
 			data->init( cons );
 			data->levelCouldBeSkipped = levelCouldBeSkipped;
 			transports.emplace_back( data ); 
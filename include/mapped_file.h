@@ -0,0 +1,75 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "internal_msg.h"
+
+namespace nodecpp::platform::internal_msg { 
+
+	// A file mapped read-only as a whole, to be read through the same ReadIter as messages are (typed readers, gather(), 
+	// appending to a message, etc.), with no copying and no memory but the OS page cache.
+	// Errors of opening a file are reported by nodecpp::error::system_error
+	class MappedFile
+	{
+		const uint8_t* data_ = nullptr;
+		size_t size_ = 0;
+
+	public:
+		MappedFile() {}
+		explicit MappedFile( const char* path ) { open( path ); }
+		MappedFile( const MappedFile& ) = delete;
+		MappedFile& operator = ( const MappedFile& ) = delete;
+		MappedFile( MappedFile&& other ) noexcept : data_( other.data_ ), size_( other.size_ ) { other.data_ = nullptr; other.size_ = 0; }
+		MappedFile& operator = ( MappedFile&& other ) noexcept
+		{
+			if ( this == &other ) return *this;
+			close();
+			data_ = other.data_;
+			size_ = other.size_;
+			other.data_ = nullptr;
+			other.size_ = 0;
+			return *this;
+		}
+		~MappedFile() { close(); }
+
+		void open( const char* path );
+		void close();
+		// for data to be read once, from the beginning to the end (pages are read ahead more aggressively, and dropped earlier)
+		void adviseSequential();
+
+		const uint8_t* data() const { return data_; }
+		size_t size() const { return size_; }
+
+		template<class MsgT = InternalMsg>
+		typename MsgT::ReadIter getReadIter() const { return typename MsgT::ReadIter( data_, size_ ); }
+	};
+
+} // nodecpp
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,107 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdio.h>
+
+namespace nodecpp
+{
+
+// Subsystems that memory obtained from VirtualMemory is attributed to
+enum class MemoryTag : uint8_t { other = 0, log, message, arena, pageCache, guardedRegion, count };
+
+// MemoryAccounting: per-tag counters of memory held by the foundation layer, with peak values
+//   - reserved: address space; committed: accessible memory (reserved as well), as committed and not yet decommitted by VirtualMemory;
+//     NOTE: on POSIX, what is decommitted without VirtualMemory::releaseCommitCharge is not counted here, but still holds 
+//     the OS commit charge (see VirtualMemory::DecommitMemory()), so the sum may be below the process's Committed_AS;
+//     resident: committed less what has been given back to OS by VirtualMemory::ResetMemory() and not yet reused 
+//     (an upper bound: pages that have never been touched are counted, too)
+//   - counters are lock-free (relaxed atomics), one cache line per tag
+//   - optionally, each event is also recorded in a trace ring of traceRingSize most recent events, which can be dumped on demand
+// Events are reported by VirtualMemory (with a tag passed to it by a caller) and by layers that pass memory from one 
+// subsystem to another without going to OS (say, PageCache); a caller must pass the same tag when giving memory back.
+// Defining NODECPP_NO_MEMORY_ACCOUNTING compiles all of it out.
+class MemoryAccounting
+{
+public:
+	struct Stats
+	{
+		size_t reserved;
+		size_t committed;
+		size_t resident;
+		size_t peakReserved;
+		size_t peakCommitted;
+	};
+
+	enum class Event : uint8_t { reserve, unreserve, commit, decommit, reset, reuse, transferIn, transferOut };
+	static constexpr size_t traceRingSize = 0x1000;
+
+	static const char* tagName( MemoryTag tag );
+	static const char* eventName( Event event );
+
+#ifndef NODECPP_NO_MEMORY_ACCOUNTING
+	static Stats getStats( MemoryTag tag );
+	static Stats getTotalStats(); // peak values are sums of peaks per tag
+	static void logStats();
+
+	static void enableTrace( bool enable );
+	static bool isTraceEnabled();
+	static void dumpTrace( FILE* f );
+
+	static void onReserve( MemoryTag tag, const void* addr, size_t size );
+	static void onUnreserve( MemoryTag tag, const void* addr, size_t size );
+	static void onCommit( MemoryTag tag, const void* addr, size_t size );
+	static void onDecommit( MemoryTag tag, const void* addr, size_t size );
+	static void onReset( MemoryTag tag, const void* addr, size_t size );
+	static void onReuse( MemoryTag tag, const void* addr, size_t size ); // reset memory is about to be written again
+	static void onTransfer( MemoryTag from, MemoryTag to, const void* addr, size_t size ); // committed memory changes hands
+#else
+	static Stats getStats( MemoryTag ) { return Stats{}; }
+	static Stats getTotalStats() { return Stats{}; }
+	static void logStats() {}
+
+	static void enableTrace( bool ) {}
+	static bool isTraceEnabled() { return false; }
+	static void dumpTrace( FILE* ) {}
+
+	static void onReserve( MemoryTag, const void*, size_t ) {}
+	static void onUnreserve( MemoryTag, const void*, size_t ) {}
+	static void onCommit( MemoryTag, const void*, size_t ) {}
+	static void onDecommit( MemoryTag, const void*, size_t ) {}
+	static void onReset( MemoryTag, const void*, size_t ) {}
+	static void onReuse( MemoryTag, const void*, size_t ) {}
+	static void onTransfer( MemoryTag, MemoryTag, const void*, size_t ) {}
+#endif // NODECPP_NO_MEMORY_ACCOUNTING
+};
+
+} // namespace nodecpp
+
+#endif // MEMORY_ACCOUNTING_H
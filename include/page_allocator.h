@@ -40,24 +40,89 @@
 #ifndef PAGE_ALLOCATOR_H
 #define PAGE_ALLOCATOR_H
 
+#include <cstddef>
+#include <cstdint>
+#include "memory_accounting.h"
+
 namespace nodecpp
 {
 
 class VirtualMemory
 {
-// NOTE: implementations are OS-specific
 public:
+	struct MemoryRange
+	{
+		void* addr;
+		size_t size;
+	};
+
+private:
+	// NOTE: implementations are OS-specific
+	static void* implAllocate(size_t size);
+	static void* implAllocate(size_t size, uint32_t flags, size_t* effectivePageSize);
+	static void implDeallocate(void* ptr, size_t size);
+	static void implAllocateMany(void** out, size_t count, size_t size);
+	static void implDeallocateMany(void* const* ptrs, size_t count, size_t size);
+	static void* implAllocateAddressSpace(size_t size);
+	static void implFreeAddressSpace(void* addr, size_t size);
+	static void* implCommitMemory(void* addr, size_t size);
+	static void* implCommitMemory(void* addr, size_t size, uint32_t flags);
+	static void implDecommitMemory(void* addr, size_t size, uint32_t flags);
+	static void implDecommitMemory(const MemoryRange* ranges, size_t count, uint32_t flags);
+	static void implResetMemory(void* addr, size_t size);
+
+public:
+	// Allocation flags
+	//   largePages, hugePages: request large (typically 2Mb) or huge (typically 1Gb) pages (mutually exclusive);
+	//   size must then be a multiple of getLargePageSize() or getHugePageSize(), respectively.
+	//   If explicitly reserved pages are not available, a regular allocation is returned and, where supported, 
+	//   marked as a candidate for transparent large pages; effectivePageSize reports what is actually guaranteed
+	//   prefault: pages are populated right away (rather than on first touch)
+	//   lockInMemory: pages are populated and locked in RAM; failure to lock (say, due to RLIMIT_MEMLOCK) is logged, but is not an error
+	//   releaseCommitCharge (DecommitMemory() only): the commit charge of the range is given back, too (see DecommitMemory())
+	enum AllocFlags : uint32_t { noFlags = 0, largePages = 0x1, hugePages = 0x2, prefault = 0x4, lockInMemory = 0x8, releaseCommitCharge = 0x10 };
+
 	static size_t getPageSize();
 	static size_t getAllocGranularity();
+	static size_t getLargePageSize();
+	static size_t getHugePageSize();
+
+	// Memory is accounted to a tag (see MemoryAccounting); whatever is given back must be given back with the same tag.
+
+	static void* allocate(size_t size, MemoryTag tag = MemoryTag::other);
+	static void* allocate(size_t size, uint32_t flags, size_t* effectivePageSize = nullptr, MemoryTag tag = MemoryTag::other);
+	static void deallocate(void* ptr, size_t size, MemoryTag tag = MemoryTag::other);
+	// count blocks of size bytes each, obtained (where possible) from a single mapping; each block can be deallocated separately
+	static void allocateMany(void** out, size_t count, size_t size, MemoryTag tag = MemoryTag::other);
+	// blocks adjacent in memory (and given in ascending order) are released together
+	static void deallocateMany(void* const* ptrs, size_t count, size_t size, MemoryTag tag = MemoryTag::other);
+
+	static void* AllocateAddressSpace(size_t size, MemoryTag tag = MemoryTag::other);
+	// NOTE: what is still committed in the range must be decommitted (or, at least, reported by MemoryAccounting::onDecommit()) first
+	static void FreeAddressSpace(void* addr, size_t size, MemoryTag tag = MemoryTag::other);
 
-	static void* allocate(size_t size);
-	static void deallocate(void* ptr, size_t size);
+	static void* CommitMemory(void* addr, size_t size, MemoryTag tag = MemoryTag::other);
+	static void* CommitMemory(void* addr, size_t size, uint32_t flags, MemoryTag tag = MemoryTag::other);
+	// gives physical pages back to the OS; the range must be committed again before use 
+	// (on POSIX it actually remains accessible and reads as zeros, but this must not be relied upon).
+	// NOTE: on POSIX the range stays writable, and thus keeps its commit charge (Committed_AS on Linux, which is what 
+	//       vm.overcommit_memory=2 limits) until it is freed; with releaseCommitCharge it is remapped inaccessible instead, 
+	//       which gives the charge back at the cost of a mapping change now and at the next CommitMemory(). On Windows 
+	//       decommitting always gives the charge back.
+	// Pages locked by lockInMemory are unlocked
+	static void DecommitMemory(void* addr, size_t size, MemoryTag tag = MemoryTag::other);
+	static void DecommitMemory(void* addr, size_t size, uint32_t flags, MemoryTag tag = MemoryTag::other);
+	// same for a number of ranges at once; ranges adjacent in memory (and given in ascending order) are coalesced
+	static void DecommitMemory(const MemoryRange* ranges, size_t count, MemoryTag tag = MemoryTag::other);
+	static void DecommitMemory(const MemoryRange* ranges, size_t count, uint32_t flags, MemoryTag tag = MemoryTag::other);
 
-	static void* AllocateAddressSpace(size_t size);
-	static void FreeAddressSpace(void* addr, size_t size);
+	// populates pages of a committed range (addr and size need not be page-aligned) so that first touches do not fault; 
+	// content is preserved, and it is safe to call while the range is being used by other threads
+	static void PrefaultMemory(void* addr, size_t size);
 
-	static void* CommitMemory(void* addr, size_t size);
-	static void DecommitMemory(void* addr, size_t size);
+	// lets the OS reclaim physical pages whenever it needs them; the range stays accessible, 
+	// but its content is undefined (zeroed if reclaimed) until it is written again; pages locked by lockInMemory are unlocked
+	static void ResetMemory(void* addr, size_t size, MemoryTag tag = MemoryTag::other);
 };
 
 
@@ -0,0 +1,76 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "memory_accounting.h"
+
+namespace nodecpp
+{
+
+// PageCache: keeps runs of pages released by their users so that subsequent requests of the same size
+// are served without a syscall (and without a TLB shootdown that munmap() implies).
+//   - runs of up to maxCachedRunPages pages are cached; longer runs go directly to VirtualMemory
+//   - each thread keeps up to threadCacheDepth runs of each size; on overflow, batchSize oldest of them 
+//     are moved, as a single batch, to a global lock-free list; an empty thread cache is refilled from it by a batch, too
+//   - if memory held by global lists exceeds a high-water mark, trim() gives pages of batches over the mark 
+//     back to OS by VirtualMemory::ResetMemory() (MADV_FREE); runs stay in cache and can be reused as is
+// NOTE: a run must be released with the same number of pages as it has been acquired with
+//       and must not be passed to VirtualMemory directly; content of an acquired run is undefined
+class PageCache
+{
+public:
+	static constexpr size_t maxCachedRunPages = 16;
+	static constexpr size_t threadCacheDepth = 16;
+	static constexpr size_t batchSize = 8;
+	static constexpr size_t defaultHighWaterMark = 0x4000000; // 64Mb
+	static_assert( batchSize <= threadCacheDepth );
+
+	// runs are accounted to a tag while in use, and to MemoryTag::pageCache while cached 
+	// (per thread, changes are reported to MemoryAccounting in portions of 1Mb or by flushThreadCache())
+	static void* acquire( size_t pageCnt, MemoryTag tag = MemoryTag::other );
+	static void release( void* ptr, size_t pageCnt, MemoryTag tag = MemoryTag::other );
+	// same for count runs at once; whatever cannot be served from cache is obtained from VirtualMemory by a single call
+	static void acquireMany( void** out, size_t count, size_t pageCnt, MemoryTag tag = MemoryTag::other );
+	static void releaseMany( void* const* ptrs, size_t count, size_t pageCnt, MemoryTag tag = MemoryTag::other );
+
+	static void flushThreadCache(); // moves runs cached by the calling thread to global lists and reports pending accounting changes
+
+	static void setHighWaterMark( size_t bytes );
+	static size_t getHighWaterMark();
+	static void trim();
+
+	static size_t cachedBytes(); // held by global lists (not including per-thread caches)
+	static size_t residentCachedBytes(); // same but not including what has been given back to OS by trim()
+};
+
+} // namespace nodecpp
+
+#endif // PAGE_CACHE_H
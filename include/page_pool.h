@@ -0,0 +1,86 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef PAGE_POOL_H
+#define PAGE_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nodecpp
+{
+
+// PagePool: fixed-size pages (pageSize bytes, aligned to pageSize) for message buffers (see internal_msg.h)
+//   - pages are carved out of chunks of chunkSize bytes (aligned to chunkSize) committed within large reserved regions 
+//     (accounted to MemoryTag::message); the first page of a chunk holds its header, other pages of a fresh chunk 
+//     are handed out one by one and are not touched before that
+//   - each thread has a heap that owns chunks it has obtained. Free pages are linked into per-heap lists through their first bytes; 
+//     a heap keeps up to 2 * batchPages of them, and moves batchPages at once to a global lock-free list on overflow; 
+//     an empty heap is refilled by pages returned by other threads, then by a batch from the global list, then from a fresh chunk
+//   - a page released by a thread other than the owner of its chunk is collected in a per-thread outbox and is returned, 
+//     by batches of remoteBatchPages, to the owner's lock-free return list; the owner takes it back when it runs out of pages.
+//     Messages built on one thread and destroyed on another thus keep pages cycling between them without draining one heap and bloating the other
+//   - heaps of exited threads are adopted by new threads (along with their chunks and whatever is being returned to them)
+//   - chunks are never given back to OS, that is, memory held by the pool is that of the peak usage
+//   - a page can have more than one holder (see addRef()); it is actually released by the last of them
+//   - cells (cellSize bytes, aligned to cellSize) are for small messages; they are carved out of pool pages, and are cached 
+//     the same way, by batches of cellBatch (but are not returned to owners); pages split into cells stay split
+// NOTE: content of an acquired page is undefined
+class PagePool
+{
+public:
+	static constexpr size_t pageSize = 0x1000;
+	static constexpr size_t chunkSize = 0x100000; // 1Mb
+	static constexpr size_t batchPages = 0x100; // 1Mb
+	static constexpr size_t remoteBatchPages = 0x40;
+	static_assert( chunkSize % pageSize == 0 );
+	static_assert( remoteBatchPages <= batchPages );
+	static constexpr size_t cellSize = 0x200;
+	static constexpr size_t cellBatch = 0x40;
+	static_assert( pageSize % cellSize == 0 );
+
+	static void* acquirePage();
+	static void releasePage( void* page ); // by any thread
+	// adds a holder to an acquired page; each holder calls releasePage() once. Sharing is up to holders: 
+	// normally, a shared page is not modified by any of them
+	static void addRef( void* page );
+	static bool isShared( const void* page );
+
+	static void* acquireCell();
+	static void releaseCell( void* cell ); // by any thread
+
+	// moves pages cached by the calling thread to the global list, and sends pages in its outboxes to their owners
+	static void flushThreadCache();
+
+	static bool isOwnedByCallingThread( const void* page );
+	static size_t reservedBytes(); // by all chunks obtained so far
+	static size_t globalCachedPages(); // held by the global list (not including per-thread caches)
+};
+
+} // namespace nodecpp
+
+#endif // PAGE_POOL_H
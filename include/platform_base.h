@@ -123,6 +123,13 @@ static_assert(sizeof(void*) == 8);
 #include <cstddef>
 #include <functional>
 
+//CACHE LINE (as far as false sharing is concerned)
+#if defined(NODECPP_ARM64) && defined(NODECPP_MAC)
+#define NODECPP_CACHE_LINE_SIZE 128
+#else
+#define NODECPP_CACHE_LINE_SIZE 64
+#endif
+
 //MMU-BASED SYSTEMS IN PROTECTED MODE
 #if defined(NODECPP_LINUX) || defined(NODECPP_WINDOWS) || defined(NODECPP_MAC) || defined(NODECPP_ANDROID)
 
@@ -0,0 +1,127 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef SHM_PAGE_POOL_H
+#define SHM_PAGE_POOL_H
+
+#include "platform_base.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace nodecpp
+{
+
+// Single-producer single-consumer ring of 64-bit descriptors; lives in shared memory (see ShmPagePool::ring()), 
+// so that its producer and consumer can be in different processes. Each side caches the position of the other one 
+// within its own cache line, and re-reads it only when the ring seems to be full (empty)
+class ShmRing
+{
+public:
+	static constexpr size_t capacity = 0x400;
+
+private:
+	alignas(NODECPP_CACHE_LINE_SIZE) std::atomic<uint64_t> head; // next to be written
+	uint64_t cachedTail;
+	alignas(NODECPP_CACHE_LINE_SIZE) std::atomic<uint64_t> tail; // next to be read
+	uint64_t cachedHead;
+	alignas(NODECPP_CACHE_LINE_SIZE) uint64_t slots[capacity];
+	static_assert( std::atomic<uint64_t>::is_always_lock_free ); // and thus address-free
+
+public:
+	void init() { head.store( 0, std::memory_order_relaxed ); cachedTail = 0; tail.store( 0, std::memory_order_relaxed ); cachedHead = 0; }
+
+	bool push( uint64_t descriptor ) // by the producer; false if the ring is full
+	{
+		uint64_t h = head.load( std::memory_order_relaxed );
+		if ( h - cachedTail == capacity )
+		{
+			cachedTail = tail.load( std::memory_order_acquire );
+			if ( h - cachedTail == capacity )
+				return false;
+		}
+		slots[h % capacity] = descriptor;
+		head.store( h + 1, std::memory_order_release );
+		return true;
+	}
+	bool pop( uint64_t& descriptor ) // by the consumer; false if the ring is empty
+	{
+		uint64_t t = tail.load( std::memory_order_relaxed );
+		if ( t == cachedHead )
+		{
+			cachedHead = head.load( std::memory_order_acquire );
+			if ( t == cachedHead )
+				return false;
+		}
+		descriptor = slots[t % capacity];
+		tail.store( t + 1, std::memory_order_release );
+		return true;
+	}
+};
+
+// ShmPagePool: pages (pageSize bytes) of a memory region shared by processes of the same host, for messages to be passed 
+// between them without copying (see internal_msg_shm.h)
+//   - a region is either an anonymous memfd (shared with children by fork(), or with other processes by passing its fd), 
+//     or a named POSIX shared memory object; a process maps a single region at a time, at an address of its own, 
+//     so that pages are referred to by offsets within the region (see toOffset()/fromOffset())
+//   - free pages of all processes are kept by a lock-free list within the region (ABA is addressed by a counter stored 
+//     in lower bits of a head offset); pages that have never been used are taken from the end of the used part
+//   - the region also holds ringCnt rings (see ShmRing) for processes to pass descriptors to each other
+//   - mapping and unmapping is accounted to MemoryTag::message, in each process that maps a region
+// NOTE: POSIX only; on Windows, create() and attach() fail
+class ShmPagePool
+{
+	static uint8_t* base_;
+
+public:
+	static constexpr size_t pageSize = 0x1000;
+	static constexpr size_t ringCnt = 4;
+
+	// creates a region of a given size (that is, of a little less pages, because of its header), maps it, and returns its fd
+	static int create( size_t size, const char* name = nullptr );
+	// maps a region created by another process (instead of the one mapped so far, if any); an fd is not closed
+	static void attach( int fd );
+	static int attach( const char* name ); // returns an fd to be closed by a caller
+	static void detach(); // the region itself lives until all processes unmap it (and, for a named one, until remove())
+	static void remove( const char* name );
+
+	static bool isAttached() { return base_ != nullptr; }
+	static uint8_t* base() { return base_; }
+	static uint64_t toOffset( const void* ptr ) { return ptr != nullptr ? reinterpret_cast<const uint8_t*>( ptr ) - base_ : 0; }
+	static void* fromOffset( uint64_t offset ) { return offset != 0 ? base_ + offset : nullptr; }
+
+	static void* acquirePage();
+	static void releasePage( void* page ); // by any process
+
+	static ShmRing& ring( size_t idx );
+	static size_t usedPages(); // by all processes
+	static size_t totalPages();
+};
+
+} // namespace nodecpp
+
+#endif // SHM_PAGE_POOL_H
@@ -41,6 +41,7 @@ namespace nodecpp::error {
 		unknown = -1,
 
 		bad_address = EFAULT,
+		bad_message = EBADMSG,
 		file_exists = EEXIST,
 		no_such_file_or_directory = ENOENT,
 		not_enough_memory = ENOMEM,
@@ -58,6 +59,7 @@ namespace nodecpp::error {
 			msgs[0] = "Success";
 
 			msgs[EFAULT] = "Bad address";
+			msgs[EBADMSG] = "Bad message";
 			msgs[EEXIST] = "File exists";
 			msgs[ENOENT] = "No such file or directory";
 			msgs[ENOMEM] = "Cannot allocate memory";
@@ -167,6 +169,7 @@ namespace nodecpp::error {
 	};
 
 	extern const nodecpp::error::system_error bad_address;
+	extern const nodecpp::error::system_error bad_message;
 	extern const nodecpp::error::system_error file_exists;
 	extern const nodecpp::error::system_error no_such_file_or_directory;
 	extern const nodecpp::error::system_error not_enough_memory;
@@ -0,0 +1,112 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#ifndef ABA_TAG_IMPL_H
+#define ABA_TAG_IMPL_H
+
+#include "../include/foundation.h"
+#include "../include/nodecpp_assert.h"
+
+#include <atomic>
+
+namespace nodecpp::aba_tag_impl {
+
+	// A word holding an aligned value (an address or an offset) and an ABA counter in bits that the value never uses: 
+	// lower ones (below alignment) and, optionally, a number of upper ones. The counter is incremented by every change 
+	// of the word, and carries from its lower part to its upper one, so that all of its bits count
+	template<class Word, size_t alignment, size_t upperBits>
+	struct AbaTag
+	{
+		static_assert( alignment != 0 && ( alignment & ( alignment - 1 ) ) == 0 );
+		static_assert( upperBits < sizeof( Word ) * 8 );
+		static constexpr Word upperMask = upperBits == 0 ? 0 : ~( ( Word(1) << ( sizeof( Word ) * 8 - upperBits ) ) - 1 );
+		static constexpr Word mask = upperMask | ( alignment - 1 );
+
+		// bits in between are set, so that the carry goes from lower bits of the counter to upper ones
+		static constexpr Word nextTag( Word prev ) { return ( ( prev | ~mask ) + 1 ) & mask; }
+		static_assert( upperBits == 0 || nextTag( alignment - 1 ) == ( upperMask & ~( upperMask << 1 ) ) );
+		static_assert( nextTag( mask ) == 0 );
+
+		static constexpr bool fits( Word value ) { return ( value & mask ) == 0; }
+		static constexpr Word value( Word w ) { return w & ~mask; }
+		static constexpr Word make( Word value, Word prev ) { return value | nextTag( prev ); }
+	};
+
+	// upper bits of an address that user space does not use (see also tagged_ptr_impl.h)
+	constexpr size_t unusedUpperAddressBits = sizeof( uintptr_t ) == 8 ? 16 : 0;
+
+	// Treiber stack of alignment-aligned nodes linked by their 'link' member. ABA is addressed by AbaTag of the head, that is, 
+	// by a counter of 25 bits for 512-byte alignment, and of 28 bits for 4Kb alignment, on 64-bit platforms.
+	// Nodes must never be unmapped while being in a stack, so that reading 'link' of a node that has just been popped 
+	// by another thread is safe (the value is then garbage, but CAS fails as the counter has changed)
+	template<class Node, Node* Node::*link, size_t alignment>
+	class alignas(NODECPP_CACHE_LINE_SIZE) TaggedStack
+	{
+		using Tag = AbaTag<uintptr_t, alignment, unusedUpperAddressBits>;
+		std::atomic<uintptr_t> head = 0;
+
+		static Node* ptr( uintptr_t h ) { return reinterpret_cast<Node*>( Tag::value( h ) ); }
+		static uintptr_t makeHead( Node* n, uintptr_t prev )
+		{
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, Tag::fits( reinterpret_cast<uintptr_t>( n ) ), "0x{:x}", reinterpret_cast<uintptr_t>( n ) );
+			return Tag::make( reinterpret_cast<uintptr_t>( n ), prev );
+		}
+
+	public:
+		// pushes a chain of nodes already linked from first to last
+		void push( Node* first, Node* last )
+		{
+			uintptr_t h = head.load( std::memory_order_relaxed );
+			do {
+				last->*link = ptr( h );
+			} while ( !head.compare_exchange_weak( h, makeHead( first, h ), std::memory_order_release, std::memory_order_relaxed ) );
+		}
+		void push( Node* n ) { push( n, n ); }
+		Node* pop()
+		{
+			uintptr_t h = head.load( std::memory_order_acquire );
+			for (;;)
+			{
+				Node* n = ptr( h );
+				if ( n == nullptr )
+					return nullptr;
+				Node* next = n->*link;
+				if ( head.compare_exchange_weak( h, makeHead( next, h ), std::memory_order_acquire, std::memory_order_acquire ) )
+					return n;
+			}
+		}
+		Node* popAll()
+		{
+			uintptr_t h = head.load( std::memory_order_acquire );
+			while ( ptr( h ) != nullptr && !head.compare_exchange_weak( h, makeHead( nullptr, h ), std::memory_order_acquire, std::memory_order_acquire ) );
+			return ptr( h );
+		}
+	};
+
+} // nodecpp::aba_tag_impl
+
+#endif // ABA_TAG_IMPL_H
@@ -0,0 +1,106 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include "../include/foundation.h"
+#include "../include/arena_allocator.h"
+
+namespace nodecpp {
+
+static size_t roundUpToPage( size_t sz )
+{
+	size_t pageSize = VirtualMemory::getPageSize();
+	return ( sz + pageSize - 1 ) & ~( pageSize - 1 );
+}
+
+ArenaAllocator::ArenaAllocator( size_t reservedSize, size_t commitChunkSize_, uint32_t flags, MemoryTag tag_ ) : commitFlags( flags ), tag( tag_ )
+{
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, reservedSize != 0 );
+	reservedSize = roundUpToPage( reservedSize );
+	commitChunkSize = commitChunkSize_ ? roundUpToPage( commitChunkSize_ ) : VirtualMemory::getPageSize();
+	begin_ = reinterpret_cast<uint8_t*>( VirtualMemory::AllocateAddressSpace( reservedSize, tag ) );
+	pos = begin_;
+	committedEnd = begin_;
+	reservedEnd = begin_ + reservedSize;
+}
+
+ArenaAllocator::~ArenaAllocator()
+{
+	if ( begin_ != nullptr )
+	{
+		MemoryAccounting::onDecommit( tag, begin_, committedSize() );
+		VirtualMemory::FreeAddressSpace( begin_, reservedEnd - begin_, tag );
+	}
+}
+
+void* ArenaAllocator::allocateSlow( size_t sz, size_t alignment )
+{
+	uintptr_t ret = ( (uintptr_t)pos + alignment - 1 ) & ~( (uintptr_t)alignment - 1 );
+	if ( ret > (uintptr_t)reservedEnd || sz > (uintptr_t)reservedEnd - ret )
+	{
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "arena of 0x{:x} bytes exhausted at allocate(0x{:x}, {}), 0x{:x} bytes used", reservedSize(), sz, alignment, usedSize() );
+		throw std::bad_alloc();
+	}
+	uint8_t* end = reinterpret_cast<uint8_t*>( ret ) + sz;
+	commitUpTo( end, commitFlags );
+	pos = end;
+	return reinterpret_cast<void*>( ret );
+}
+
+void ArenaAllocator::commitUpTo( uint8_t* end, uint32_t flags )
+{
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, end > committedEnd && end <= reservedEnd );
+	size_t toCommit = ( ( end - committedEnd ) + commitChunkSize - 1 ) / commitChunkSize * commitChunkSize;
+	if ( toCommit > (size_t)( reservedEnd - committedEnd ) )
+		toCommit = reservedEnd - committedEnd;
+	VirtualMemory::CommitMemory( committedEnd, toCommit, flags, tag );
+	committedEnd += toCommit;
+}
+
+void ArenaAllocator::commitAhead( size_t size )
+{
+	uint8_t* end = size < (size_t)( reservedEnd - pos ) ? pos + size : reservedEnd;
+	if ( end <= pos )
+		return;
+	// what is already committed might have never been touched yet
+	uint8_t* alreadyCommittedEnd = end < committedEnd ? end : committedEnd;
+	if ( alreadyCommittedEnd > pos )
+		VirtualMemory::PrefaultMemory( pos, alreadyCommittedEnd - pos );
+	if ( end > committedEnd )
+		commitUpTo( end, commitFlags | VirtualMemory::prefault );
+}
+
+void ArenaAllocator::releaseUnused( size_t keepSize, uint32_t decommitFlags )
+{
+	size_t keep = usedSize() > keepSize ? usedSize() : keepSize;
+	keep = roundUpToPage( keep );
+	if ( keep >= committedSize() )
+		return;
+	VirtualMemory::DecommitMemory( begin_ + keep, committedSize() - keep, decommitFlags, tag );
+	committedEnd = begin_ + keep;
+}
+
+} // namespace nodecpp
@@ -0,0 +1,276 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include "../include/foundation.h"
+#include "../include/checksum.h"
+
+#include <cstring>
+
+#if defined(NODECPP_X64) && ( defined(NODECPP_GCC) || defined(NODECPP_CLANG) )
+#include <nmmintrin.h>
+#define NODECPP_CRC32C_SSE42
+#define NODECPP_TARGET_SSE42 __attribute__((target("sse4.2")))
+#elif defined(NODECPP_X64) && defined(NODECPP_MSVC)
+#include <intrin.h>
+#include <nmmintrin.h>
+#define NODECPP_CRC32C_SSE42
+#define NODECPP_TARGET_SSE42
+#elif defined(NODECPP_ARM64) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define NODECPP_CRC32C_ARMV8
+#endif
+
+namespace nodecpp {
+
+namespace {
+
+	constexpr uint32_t crc32cPoly = 0x82f63b78; // reflected
+
+	struct Crc32cTables
+	{
+		uint32_t t[8][256];
+		constexpr Crc32cTables() : t{}
+		{
+			for ( uint32_t i=0; i<256; ++i )
+			{
+				uint32_t crc = i;
+				for ( int j=0; j<8; ++j )
+					crc = ( crc >> 1 ) ^ ( ( crc & 1 ) ? crc32cPoly : 0 );
+				t[0][i] = crc;
+			}
+			for ( uint32_t i=0; i<256; ++i )
+				for ( int k=1; k<8; ++k )
+					t[k][i] = ( t[k-1][i] >> 8 ) ^ t[0][t[k-1][i] & 0xff];
+		}
+	};
+	constexpr Crc32cTables crc32cTables;
+
+	uint64_t load64( const uint8_t* p ) { uint64_t ret; memcpy( &ret, p, sizeof( ret ) ); return ret; }
+	uint32_t load32( const uint8_t* p ) { uint32_t ret; memcpy( &ret, p, sizeof( ret ) ); return ret; }
+
+	// all of it takes a value with bits inverted (that is, ~crc)
+	uint32_t crc32cTable( const uint8_t* p, size_t sz, uint32_t crc )
+	{
+		const auto& t = crc32cTables.t;
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		for ( ; sz >= 8; sz -= 8, p += 8 )
+		{
+			uint64_t v = load64( p ) ^ crc;
+			crc = t[7][v & 0xff] ^ t[6][( v >> 8 ) & 0xff] ^ t[5][( v >> 16 ) & 0xff] ^ t[4][( v >> 24 ) & 0xff] ^ 
+				t[3][( v >> 32 ) & 0xff] ^ t[2][( v >> 40 ) & 0xff] ^ t[1][( v >> 48 ) & 0xff] ^ t[0][v >> 56];
+		}
+#endif
+		for ( ; sz != 0; --sz, ++p )
+			crc = ( crc >> 8 ) ^ t[0][( crc ^ *p ) & 0xff];
+		return crc;
+	}
+
+#ifdef NODECPP_CRC32C_SSE42
+	NODECPP_TARGET_SSE42
+	uint32_t crc32cSse42( const uint8_t* p, size_t sz, uint32_t crc )
+	{
+		uint64_t crc64 = crc;
+		for ( ; sz >= 8; sz -= 8, p += 8 )
+			crc64 = _mm_crc32_u64( crc64, load64( p ) );
+		crc = (uint32_t)crc64;
+		for ( ; sz != 0; --sz, ++p )
+			crc = _mm_crc32_u8( crc, *p );
+		return crc;
+	}
+
+	bool hasSse42()
+	{
+#ifdef NODECPP_MSVC
+		int info[4];
+		__cpuid( info, 1 );
+		return ( info[2] & ( 1 << 20 ) ) != 0;
+#else
+		return __builtin_cpu_supports( "sse4.2" );
+#endif
+	}
+#endif // NODECPP_CRC32C_SSE42
+
+#ifdef NODECPP_CRC32C_ARMV8
+	uint32_t crc32cArmv8( const uint8_t* p, size_t sz, uint32_t crc )
+	{
+		for ( ; sz >= 8; sz -= 8, p += 8 )
+			crc = __crc32cd( crc, load64( p ) );
+		for ( ; sz != 0; --sz, ++p )
+			crc = __crc32cb( crc, *p );
+		return crc;
+	}
+#endif // NODECPP_CRC32C_ARMV8
+
+	using Crc32cFn = uint32_t (*)( const uint8_t*, size_t, uint32_t );
+	struct Crc32cImpl
+	{
+		Crc32cFn fn;
+		const char* name;
+	};
+
+	Crc32cImpl selectCrc32c()
+	{
+#if defined(NODECPP_CRC32C_SSE42)
+		if ( hasSse42() )
+			return { crc32cSse42, "sse4.2" };
+#elif defined(NODECPP_CRC32C_ARMV8)
+		return { crc32cArmv8, "armv8 crc" };
+#endif
+		return { crc32cTable, "slicing-by-8" };
+	}
+
+	const Crc32cImpl& crc32cImpl()
+	{
+		static const Crc32cImpl impl = selectCrc32c();
+		return impl;
+	}
+
+	// XXH64
+	constexpr uint64_t prime1 = 11400714785074694791ull;
+	constexpr uint64_t prime2 = 14029467366897019727ull;
+	constexpr uint64_t prime3 = 1609587929392839161ull;
+	constexpr uint64_t prime4 = 9650029242287828579ull;
+	constexpr uint64_t prime5 = 2870177450012600261ull;
+
+	uint64_t rotl( uint64_t x, int r ) { return ( x << r ) | ( x >> ( 64 - r ) ); }
+	uint64_t round( uint64_t acc, uint64_t input ) { return rotl( acc + input * prime2, 31 ) * prime1; }
+	uint64_t mergeRound( uint64_t h, uint64_t acc ) { return ( h ^ round( 0, acc ) ) * prime1 + prime4; }
+
+	// input is little-endian
+	uint64_t loadLE64( const uint8_t* p )
+	{
+		uint64_t ret = load64( p );
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		ret = __builtin_bswap64( ret );
+#endif
+		return ret;
+	}
+	uint32_t loadLE32( const uint8_t* p )
+	{
+		uint32_t ret = load32( p );
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		ret = __builtin_bswap32( ret );
+#endif
+		return ret;
+	}
+
+} // anonymous namespace
+
+uint32_t crc32c( const void* data, size_t sz, uint32_t crc )
+{
+	return ~crc32cImpl().fn( reinterpret_cast<const uint8_t*>( data ), sz, ~crc );
+}
+
+uint32_t crc32cSoftware( const void* data, size_t sz, uint32_t crc )
+{
+	return ~crc32cTable( reinterpret_cast<const uint8_t*>( data ), sz, ~crc );
+}
+
+const char* crc32cImplementation()
+{
+	return crc32cImpl().name;
+}
+
+void XXH64::reset( uint64_t seed_ )
+{
+	seed = seed_;
+	acc[0] = seed + prime1 + prime2;
+	acc[1] = seed + prime2;
+	acc[2] = seed;
+	acc[3] = seed - prime1;
+	buffSz = 0;
+	totalSz = 0;
+}
+
+void XXH64::update( const void* data, size_t sz )
+{
+	const uint8_t* p = reinterpret_cast<const uint8_t*>( data );
+	totalSz += sz;
+	if ( buffSz + sz < sizeof( buff ) )
+	{
+		memcpy( buff + buffSz, p, sz );
+		buffSz += sz;
+		return;
+	}
+	if ( buffSz != 0 )
+	{
+		size_t toFill = sizeof( buff ) - buffSz;
+		memcpy( buff + buffSz, p, toFill );
+		for ( size_t i=0; i<4; ++i )
+			acc[i] = round( acc[i], loadLE64( buff + 8 * i ) );
+		p += toFill;
+		sz -= toFill;
+		buffSz = 0;
+	}
+	uint64_t v0 = acc[0], v1 = acc[1], v2 = acc[2], v3 = acc[3];
+	for ( ; sz >= 32; sz -= 32, p += 32 )
+	{
+		v0 = round( v0, loadLE64( p ) );
+		v1 = round( v1, loadLE64( p + 8 ) );
+		v2 = round( v2, loadLE64( p + 16 ) );
+		v3 = round( v3, loadLE64( p + 24 ) );
+	}
+	acc[0] = v0; acc[1] = v1; acc[2] = v2; acc[3] = v3;
+	memcpy( buff, p, sz );
+	buffSz = sz;
+}
+
+uint64_t XXH64::digest() const
+{
+	uint64_t h;
+	if ( totalSz >= 32 )
+	{
+		h = rotl( acc[0], 1 ) + rotl( acc[1], 7 ) + rotl( acc[2], 12 ) + rotl( acc[3], 18 );
+		for ( size_t i=0; i<4; ++i )
+			h = mergeRound( h, acc[i] );
+	}
+	else
+		h = seed + prime5;
+	h += totalSz;
+
+	const uint8_t* p = buff;
+	size_t sz = buffSz;
+	for ( ; sz >= 8; sz -= 8, p += 8 )
+		h = rotl( h ^ round( 0, loadLE64( p ) ), 27 ) * prime1 + prime4;
+	if ( sz >= 4 )
+	{
+		h = rotl( h ^ ( loadLE32( p ) * prime1 ), 23 ) * prime2 + prime3;
+		sz -= 4;
+		p += 4;
+	}
+	for ( ; sz != 0; --sz, ++p )
+		h = rotl( h ^ ( *p * prime5 ), 11 ) * prime1;
+
+	h ^= h >> 33;
+	h *= prime2;
+	h ^= h >> 29;
+	h *= prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+} // namespace nodecpp
@@ -27,6 +27,7 @@
 
 #include "../include/foundation.h"
 #include "../include/cpu_exceptions_translator.h"
+#include "../include/guarded_region_allocator.h"
 
 
 #if defined __clang__
@@ -40,6 +41,10 @@ void initTranslator()
   // to test other features.
 }
 
+void initTranslatorSignalStack()
+{
+}
+
 #elif defined __GNUC__ && __linux__
 
 #include <signal.h>
@@ -86,10 +91,47 @@ static void unblockSignal(int signum)
 static void sigAction(int, siginfo_t* siginfo, void*)
 {
     unblockSignal(SIGSEGV);    
-    if( (uintptr_t)(siginfo->si_addr) >= NODECPP_MINIMUM_ZERO_GUARD_PAGE_SIZE )
-		throw MemoryAccessViolationException( siginfo->si_addr );
-	else 
+    if( (uintptr_t)(siginfo->si_addr) < NODECPP_MINIMUM_ZERO_GUARD_PAGE_SIZE )
 		throw NullPointerException();
+	else if ( nodecpp::GuardedRegionAllocator::isGuardAddress( siginfo->si_addr ) )
+		throw StackOverflowException( siginfo->si_addr );
+	else 
+		throw MemoryAccessViolationException( siginfo->si_addr );
+}
+
+// Alternate signal stack of a thread; without it, the handler would have no stack to run on when the current one is exhausted
+struct SignalStack
+{
+	static constexpr size_t size = 0x10000;
+	void* stack = nullptr;
+	void init()
+	{
+		if ( stack != nullptr )
+			return;
+		stack = nodecpp::VirtualMemory::allocate( size );
+		stack_t ss;
+		ss.ss_sp = stack;
+		ss.ss_size = size;
+		ss.ss_flags = 0;
+		sigaltstack( &ss, nullptr );
+	}
+	~SignalStack()
+	{
+		if ( stack == nullptr )
+			return;
+		stack_t ss;
+		ss.ss_sp = nullptr;
+		ss.ss_size = 0;
+		ss.ss_flags = SS_DISABLE;
+		sigaltstack( &ss, nullptr );
+		nodecpp::VirtualMemory::deallocate( stack, size );
+	}
+};
+static thread_local SignalStack signalStack;
+
+void initTranslatorSignalStack()
+{
+	signalStack.init();
 }
 
 void initTranslator()
@@ -97,9 +139,10 @@ void initTranslator()
     struct kernel_sigaction ks;
     ks.k_sa_sigaction = sigAction;
     sigemptyset (&ks.k_sa_mask);
-    ks.k_sa_flags = SA_SIGINFO|0x4000000;
+    ks.k_sa_flags = SA_SIGINFO|SA_ONSTACK|0x4000000;
     ks.k_sa_restorer = sigRestorer;
     syscall (SYS_rt_sigaction, SIGSEGV, &ks, NULL, _NSIG / 8);
+    initTranslatorSignalStack();
 }
 
 #elif defined _MSC_VER
@@ -113,10 +156,12 @@ void trans_func(unsigned int u, EXCEPTION_POINTERS* ep)
     if (ep->ExceptionRecord->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && ep->ExceptionRecord->NumberParameters >= 2 )
 	{
 		void * at = (void*)(ep->ExceptionRecord->ExceptionInformation[1]);
-		if ( (uintptr_t)at >= NODECPP_MINIMUM_ZERO_GUARD_PAGE_SIZE )
-			throw MemoryAccessViolationException(at);
-		else 
+		if ( (uintptr_t)at < NODECPP_MINIMUM_ZERO_GUARD_PAGE_SIZE )
 			throw NullPointerException();
+		else if ( nodecpp::GuardedRegionAllocator::isGuardAddress( at ) )
+			throw StackOverflowException(at);
+		else 
+			throw MemoryAccessViolationException(at);
 	}
 	else
 		throw std::exception();
@@ -127,5 +172,11 @@ void initTranslator()
     _set_se_translator(trans_func);
 }
 
+void initTranslatorSignalStack()
+{
+	// nothing to do: SEH has no alternate stack, and the translator runs on the faulting one; therefore, an access to a guard page 
+	// is reported as StackOverflowException only as long as the stack pointer itself has not reached it
+}
+
 
 #endif
@@ -0,0 +1,167 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include "../include/foundation.h"
+#include "../include/guarded_region_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace nodecpp {
+
+namespace {
+
+	// Alive allocators, for the signal handler to look guard pages up without taking locks
+	std::atomic<GuardedRegionAllocator*> registry[GuardedRegionAllocator::maxInstances];
+
+	void registerAllocator( GuardedRegionAllocator* allocator )
+	{
+		for ( size_t i=0; i<GuardedRegionAllocator::maxInstances; ++i )
+		{
+			GuardedRegionAllocator* expected = nullptr;
+			if ( registry[i].compare_exchange_strong( expected, allocator ) )
+				return;
+		}
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "too many GuardedRegionAllocator's (max = {})", GuardedRegionAllocator::maxInstances );
+		throw std::bad_alloc();
+	}
+
+	void unregisterAllocator( GuardedRegionAllocator* allocator )
+	{
+		for ( size_t i=0; i<GuardedRegionAllocator::maxInstances; ++i )
+		{
+			GuardedRegionAllocator* expected = allocator;
+			if ( registry[i].compare_exchange_strong( expected, nullptr ) )
+				return;
+		}
+	}
+
+	size_t roundUpToPage( size_t sz )
+	{
+		size_t pageSize = VirtualMemory::getPageSize();
+		return ( sz + pageSize - 1 ) & ~( pageSize - 1 );
+	}
+
+} // anonymous namespace
+
+GuardedRegionAllocator::GuardedRegionAllocator( size_t regionSize, size_t maxRegions, size_t guardSize )
+{
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, regionSize != 0 && maxRegions != 0 );
+	regionSz = roundUpToPage( regionSize );
+	guardSz = guardSize ? roundUpToPage( guardSize ) : VirtualMemory::getPageSize();
+	slotSz = guardSz + regionSz;
+	maxRegionCnt = maxRegions;
+	base = reinterpret_cast<uint8_t*>( VirtualMemory::AllocateAddressSpace( slotSz * maxRegionCnt + guardSz, MemoryTag::guardedRegion ) );
+	try {
+		registerAllocator( this );
+	}
+	catch (...) {
+		VirtualMemory::FreeAddressSpace( base, slotSz * maxRegionCnt + guardSz, MemoryTag::guardedRegion );
+		throw;
+	}
+}
+
+GuardedRegionAllocator::~GuardedRegionAllocator()
+{
+	unregisterAllocator( this );
+	MemoryAccounting::onDecommit( MemoryTag::guardedRegion, base, ( unusedSlotIdx - trimmedRegions.size() ) * regionSz );
+	VirtualMemory::FreeAddressSpace( base, slotSz * maxRegionCnt + guardSz, MemoryTag::guardedRegion );
+}
+
+bool GuardedRegionAllocator::isRegionStart( const void* region ) const
+{
+	const uint8_t* p = reinterpret_cast<const uint8_t*>( region );
+	return p >= base + guardSz && p < base + slotSz * maxRegionCnt && ( p - base ) % slotSz == guardSz;
+}
+
+void* GuardedRegionAllocator::allocate()
+{
+	std::unique_lock<std::mutex> lock( mx );
+	if ( !freeRegions.empty() )
+	{
+		void* ret = freeRegions.back();
+		freeRegions.pop_back();
+		return ret;
+	}
+	void* ret;
+	if ( !trimmedRegions.empty() )
+	{
+		ret = trimmedRegions.back();
+		trimmedRegions.pop_back();
+	}
+	else if ( unusedSlotIdx < maxRegionCnt )
+		ret = base + unusedSlotIdx++ * slotSz + guardSz;
+	else
+	{
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "all {} guarded regions of size 0x{:x} are in use", maxRegionCnt, regionSz );
+		throw std::bad_alloc();
+	}
+	lock.unlock();
+	return VirtualMemory::CommitMemory( ret, regionSz, MemoryTag::guardedRegion );
+}
+
+void GuardedRegionAllocator::deallocate( void* region )
+{
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, isRegionStart( region ), "0x{:x}", (uintptr_t)region );
+	std::unique_lock<std::mutex> lock( mx );
+	freeRegions.push_back( region );
+}
+
+void GuardedRegionAllocator::trim()
+{
+	std::vector<void*> toTrim;
+	{
+		std::unique_lock<std::mutex> lock( mx );
+		toTrim.swap( freeRegions );
+	}
+	if ( toTrim.empty() )
+		return;
+	std::sort( toTrim.begin(), toTrim.end() );
+	std::vector<VirtualMemory::MemoryRange> ranges;
+	ranges.reserve( toTrim.size() );
+	for ( void* region : toTrim )
+		ranges.push_back( { region, regionSz } );
+	VirtualMemory::DecommitMemory( ranges.data(), ranges.size(), MemoryTag::guardedRegion );
+	std::unique_lock<std::mutex> lock( mx );
+	trimmedRegions.insert( trimmedRegions.end(), toTrim.begin(), toTrim.end() );
+}
+
+/*static*/
+bool GuardedRegionAllocator::isGuardAddress( const void* addr )
+{
+	const uint8_t* p = reinterpret_cast<const uint8_t*>( addr );
+	for ( size_t i=0; i<maxInstances; ++i )
+	{
+		GuardedRegionAllocator* allocator = registry[i].load( std::memory_order_acquire );
+		if ( allocator == nullptr || p < allocator->base || p >= allocator->base + allocator->slotSz * allocator->maxRegionCnt + allocator->guardSz )
+			continue;
+		return (size_t)( p - allocator->base ) % allocator->slotSz < allocator->guardSz;
+	}
+	return false;
+}
+
+} // namespace nodecpp
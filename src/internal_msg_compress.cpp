@@ -0,0 +1,255 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include "../include/foundation.h"
+#include "../include/internal_msg_compress.h"
+#include "../include/std_error.h"
+
+#include <cstring>
+#include <lz4frame.h>
+#include <zstd.h>
+
+namespace nodecpp::platform::internal_msg { 
+
+namespace {
+
+	constexpr int zstdMinWindowLog = 10;
+	constexpr int zstdMaxWindowLog = 22; // that is, CompressionOptions::maxBlockSize
+	static_assert( ( size_t(1) << zstdMaxWindowLog ) == CompressionOptions::maxBlockSize );
+
+	LZ4F_blockSizeID_t lz4BlockSizeId( size_t blockSize )
+	{
+		if ( blockSize <= 0x10000 )
+			return LZ4F_max64KB;
+		if ( blockSize <= 0x40000 )
+			return LZ4F_max256KB;
+		if ( blockSize <= 0x100000 )
+			return LZ4F_max1MB;
+		return LZ4F_max4MB;
+	}
+
+	int zstdWindowLog( size_t blockSize )
+	{
+		int ret = zstdMinWindowLog;
+		while ( ( size_t(1) << ret ) < blockSize )
+			++ret;
+		return ret;
+	}
+
+	void checkLz4( size_t ret, const char* where )
+	{
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, !LZ4F_isError( ret ), "{}: {}", where, LZ4F_getErrorName( ret ) );
+	}
+
+	void checkZstd( size_t ret, const char* where )
+	{
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, !ZSTD_isError( ret ), "{}: {}", where, ZSTD_getErrorName( ret ) );
+	}
+
+	[[noreturn]] void reportNoContext( const char* what )
+	{
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "failed to create a {} context", what );
+		throw std::bad_alloc();
+	}
+
+} // anonymous namespace
+
+namespace impl {
+
+	CompressStream::CompressStream( const CompressionOptions& options, AppendFn append_, void* msg_ ) : method( options.method ), append( append_ ), msg( msg_ )
+	{
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, options.blockSize != 0 && options.blockSize <= CompressionOptions::maxBlockSize, "{}", options.blockSize );
+		if ( method == CompressionMethod::lz4 )
+		{
+			LZ4F_preferences_t prefs;
+			memset( &prefs, 0, sizeof( prefs ) );
+			prefs.frameInfo.blockSizeID = lz4BlockSizeId( options.blockSize );
+			prefs.frameInfo.contentChecksumFlag = options.checksum ? LZ4F_contentChecksumEnabled : LZ4F_noContentChecksum;
+			prefs.compressionLevel = options.level;
+			LZ4F_cctx* cctx;
+			if ( LZ4F_isError( LZ4F_createCompressionContext( &cctx, LZ4F_VERSION ) ) )
+				reportNoContext( "lz4 compression" );
+			ctx = cctx;
+			// LZ4F_compressBound() accounts for whatever may be buffered from previous calls
+			inChunk = options.blockSize;
+			outCapacity = LZ4F_compressBound( inChunk, &prefs );
+			if ( outCapacity < LZ4F_HEADER_SIZE_MAX )
+				outCapacity = LZ4F_HEADER_SIZE_MAX;
+			out.reset( new uint8_t[outCapacity] );
+			size_t sz = LZ4F_compressBegin( cctx, out.get(), outCapacity, &prefs );
+			checkLz4( sz, "LZ4F_compressBegin()" );
+			append( msg, out.get(), sz );
+		}
+		else
+		{
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, method == CompressionMethod::zstd, "{}", (int)method );
+			ZSTD_CCtx* cctx = ZSTD_createCCtx();
+			if ( cctx == nullptr )
+				reportNoContext( "zstd compression" );
+			ctx = cctx;
+			checkZstd( ZSTD_CCtx_setParameter( cctx, ZSTD_c_compressionLevel, options.level ), "ZSTD_c_compressionLevel" );
+			checkZstd( ZSTD_CCtx_setParameter( cctx, ZSTD_c_windowLog, zstdWindowLog( options.blockSize ) ), "ZSTD_c_windowLog" );
+			checkZstd( ZSTD_CCtx_setParameter( cctx, ZSTD_c_checksumFlag, options.checksum ? 1 : 0 ), "ZSTD_c_checksumFlag" );
+			inChunk = (size_t)(-1); // output is taken as it comes
+			outCapacity = ZSTD_CStreamOutSize();
+			out.reset( new uint8_t[outCapacity] );
+		}
+	}
+
+	CompressStream::~CompressStream()
+	{
+		if ( method == CompressionMethod::lz4 )
+			LZ4F_freeCompressionContext( static_cast<LZ4F_cctx*>( ctx ) );
+		else
+			ZSTD_freeCCtx( static_cast<ZSTD_CCtx*>( ctx ) );
+	}
+
+	void CompressStream::update( const uint8_t* data, size_t sz )
+	{
+		if ( method == CompressionMethod::lz4 )
+		{
+			while ( sz != 0 )
+			{
+				size_t chunk = sz < inChunk ? sz : inChunk;
+				size_t outSz = LZ4F_compressUpdate( static_cast<LZ4F_cctx*>( ctx ), out.get(), outCapacity, data, chunk, nullptr );
+				checkLz4( outSz, "LZ4F_compressUpdate()" );
+				append( msg, out.get(), outSz );
+				data += chunk;
+				sz -= chunk;
+			}
+		}
+		else
+		{
+			ZSTD_inBuffer in = { data, sz, 0 };
+			while ( in.pos < in.size )
+			{
+				ZSTD_outBuffer o = { out.get(), outCapacity, 0 };
+				checkZstd( ZSTD_compressStream2( static_cast<ZSTD_CCtx*>( ctx ), &o, &in, ZSTD_e_continue ), "ZSTD_compressStream2()" );
+				append( msg, out.get(), o.pos );
+			}
+		}
+	}
+
+	void CompressStream::finish()
+	{
+		if ( method == CompressionMethod::lz4 )
+		{
+			size_t outSz = LZ4F_compressEnd( static_cast<LZ4F_cctx*>( ctx ), out.get(), outCapacity, nullptr );
+			checkLz4( outSz, "LZ4F_compressEnd()" );
+			append( msg, out.get(), outSz );
+		}
+		else
+		{
+			ZSTD_inBuffer in = { nullptr, 0, 0 };
+			size_t remaining;
+			do {
+				ZSTD_outBuffer o = { out.get(), outCapacity, 0 };
+				remaining = ZSTD_compressStream2( static_cast<ZSTD_CCtx*>( ctx ), &o, &in, ZSTD_e_end );
+				checkZstd( remaining, "ZSTD_compressStream2()" );
+				append( msg, out.get(), o.pos );
+			} while ( remaining != 0 );
+		}
+	}
+
+	DecompressStream::DecompressStream( CompressionMethod method_, AppendFn append_, void* msg_ ) : method( method_ ), append( append_ ), msg( msg_ )
+	{
+		if ( method == CompressionMethod::lz4 )
+		{
+			LZ4F_dctx* dctx;
+			if ( LZ4F_isError( LZ4F_createDecompressionContext( &dctx, LZ4F_VERSION ) ) )
+				reportNoContext( "lz4 decompression" );
+			ctx = dctx;
+			outCapacity = 0x10000;
+		}
+		else
+		{
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, method == CompressionMethod::zstd, "{}", (int)method );
+			ZSTD_DCtx* dctx = ZSTD_createDCtx();
+			if ( dctx == nullptr )
+				reportNoContext( "zstd decompression" );
+			ctx = dctx;
+			// frames that would need more memory than we ever produce are rejected
+			checkZstd( ZSTD_DCtx_setParameter( dctx, ZSTD_d_windowLogMax, zstdMaxWindowLog ), "ZSTD_d_windowLogMax" );
+			outCapacity = ZSTD_DStreamOutSize();
+		}
+		out.reset( new uint8_t[outCapacity] );
+	}
+
+	DecompressStream::~DecompressStream()
+	{
+		if ( method == CompressionMethod::lz4 )
+			LZ4F_freeDecompressionContext( static_cast<LZ4F_dctx*>( ctx ) );
+		else
+			ZSTD_freeDCtx( static_cast<ZSTD_DCtx*>( ctx ) );
+	}
+
+	void DecompressStream::reportMalformed( const char* what )
+	{
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "malformed {} data at decompress(): {}", method == CompressionMethod::lz4 ? "lz4" : "zstd", what );
+		throw nodecpp::error::bad_message;
+	}
+
+	void DecompressStream::update( const uint8_t* data, size_t sz )
+	{
+		// the output buffer may get full before the input is consumed, and then the rest is to be taken with no more input
+		if ( method == CompressionMethod::lz4 )
+		{
+			size_t outSz;
+			do {
+				size_t inSz = sz;
+				outSz = outCapacity;
+				expected = LZ4F_decompress( static_cast<LZ4F_dctx*>( ctx ), out.get(), &outSz, data, &inSz, nullptr );
+				if ( LZ4F_isError( expected ) )
+					reportMalformed( LZ4F_getErrorName( expected ) );
+				append( msg, out.get(), outSz );
+				data += inSz;
+				sz -= inSz;
+			} while ( sz != 0 || outSz == outCapacity );
+		}
+		else
+		{
+			ZSTD_inBuffer in = { data, sz, 0 };
+			ZSTD_outBuffer o;
+			do {
+				o = { out.get(), outCapacity, 0 };
+				expected = ZSTD_decompressStream( static_cast<ZSTD_DCtx*>( ctx ), &o, &in );
+				if ( ZSTD_isError( expected ) )
+					reportMalformed( ZSTD_getErrorName( expected ) );
+				append( msg, out.get(), o.pos );
+			} while ( in.pos < in.size || o.pos == o.size );
+		}
+	}
+
+	void DecompressStream::finish()
+	{
+		if ( expected != 0 )
+			reportMalformed( "data is truncated" );
+	}
+
+} // namespace impl
+
+} // namespace nodecpp::platform::internal_msg
@@ -255,9 +255,10 @@ namespace nodecpp::log {
 			pageSize = memPageSz / pageCount;
 			buffSize = memPageSz;
 		}
-		buff = reinterpret_cast<uint8_t*>( VirtualMemory::allocate( buffSize ) );
+		buff = reinterpret_cast<uint8_t*>( PageCache::acquire( buffSize / memPageSz, MemoryTag::log ) );
 		if ( buff == nullptr )
 			throw;
+		VirtualMemory::PrefaultMemory( buff, buffSize ); // producers are not to take page faults on first rounds
 
 		NODECPP_ASSERT( foundation::module_id, ::nodecpp::assert::AssertLevel::critical, ((pageSize-1)|pageSize)+1 == (pageSize<<1) ); 
 		NODECPP_ASSERT( foundation::module_id, ::nodecpp::assert::AssertLevel::critical, ((pageCount-1)|pageCount)+1 == (pageCount<<1) ); 
@@ -0,0 +1,166 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include "../include/foundation.h"
+#include "../include/std_error.h"
+#include "../include/mapped_file.h"
+
+#ifndef NODECPP_WINDOWS
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#else
+#include <windows.h>
+#endif
+
+namespace nodecpp::platform::internal_msg { 
+
+#ifndef NODECPP_WINDOWS
+
+namespace {
+	[[noreturn]] void throwFileError( const char* what, const char* path )
+	{
+		int e = errno;
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "{} error at mapping '{}', error = {} ({})", what, path, e, strerror(e) );
+		switch ( e )
+		{
+			case ENOENT: throw nodecpp::error::no_such_file_or_directory;
+			case EACCES: throw nodecpp::error::permission_denied;
+			case ENOMEM: throw nodecpp::error::not_enough_memory;
+			default: throw nodecpp::error::system_error( nodecpp::error::errc::unknown );
+		}
+	}
+} // anonymous namespace
+
+void MappedFile::open( const char* path )
+{
+	close();
+	int fd = ::open( path, O_RDONLY );
+	if ( fd == -1 )
+		throwFileError( "open", path );
+	struct stat st;
+	if ( fstat( fd, &st ) == -1 )
+	{
+		::close( fd );
+		throwFileError( "fstat", path );
+	}
+	size_t size = (size_t)st.st_size;
+	if ( size != 0 ) // an empty file cannot be mapped, and is just empty
+	{
+		void* ptr = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( ptr == MAP_FAILED )
+		{
+			::close( fd );
+			throwFileError( "mmap", path );
+		}
+		data_ = reinterpret_cast<const uint8_t*>( ptr );
+		size_ = size;
+	}
+	::close( fd ); // the mapping keeps the file
+}
+
+void MappedFile::close()
+{
+	if ( data_ != nullptr )
+		munmap( const_cast<uint8_t*>( data_ ), size_ );
+	data_ = nullptr;
+	size_ = 0;
+}
+
+void MappedFile::adviseSequential()
+{
+	if ( data_ != nullptr )
+		madvise( const_cast<uint8_t*>( data_ ), size_, MADV_SEQUENTIAL );
+}
+
+#else
+
+namespace {
+	[[noreturn]] void throwFileError( const char* what, const char* path )
+	{
+		DWORD e = GetLastError();
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "{} error at mapping '{}', error = {}", what, path, e );
+		switch ( e )
+		{
+			case ERROR_FILE_NOT_FOUND: 
+			case ERROR_PATH_NOT_FOUND: throw nodecpp::error::no_such_file_or_directory;
+			case ERROR_ACCESS_DENIED: throw nodecpp::error::permission_denied;
+			case ERROR_NOT_ENOUGH_MEMORY: throw nodecpp::error::not_enough_memory;
+			default: throw nodecpp::error::system_error( nodecpp::error::errc::unknown );
+		}
+	}
+} // anonymous namespace
+
+void MappedFile::open( const char* path )
+{
+	close();
+	HANDLE file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( file == INVALID_HANDLE_VALUE )
+		throwFileError( "CreateFile", path );
+	LARGE_INTEGER sz;
+	if ( !GetFileSizeEx( file, &sz ) )
+	{
+		CloseHandle( file );
+		throwFileError( "GetFileSizeEx", path );
+	}
+	if ( sz.QuadPart != 0 ) // an empty file cannot be mapped, and is just empty
+	{
+		HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+		if ( mapping == NULL )
+		{
+			CloseHandle( file );
+			throwFileError( "CreateFileMapping", path );
+		}
+		void* ptr = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+		CloseHandle( mapping ); // the view keeps the mapping
+		if ( ptr == nullptr )
+		{
+			CloseHandle( file );
+			throwFileError( "MapViewOfFile", path );
+		}
+		data_ = reinterpret_cast<const uint8_t*>( ptr );
+		size_ = (size_t)sz.QuadPart;
+	}
+	CloseHandle( file );
+}
+
+void MappedFile::close()
+{
+	if ( data_ != nullptr )
+		UnmapViewOfFile( data_ );
+	data_ = nullptr;
+	size_ = 0;
+}
+
+void MappedFile::adviseSequential() {}
+
+#endif // NODECPP_WINDOWS
+
+} // nodecpp
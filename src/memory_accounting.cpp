@@ -0,0 +1,262 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include "../include/foundation.h"
+#include "../include/memory_accounting.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace nodecpp {
+
+/*static*/
+const char* MemoryAccounting::tagName( MemoryTag tag )
+{
+	switch ( tag )
+	{
+		case MemoryTag::other: return "other";
+		case MemoryTag::log: return "log";
+		case MemoryTag::message: return "message";
+		case MemoryTag::arena: return "arena";
+		case MemoryTag::pageCache: return "page cache";
+		case MemoryTag::guardedRegion: return "guarded region";
+		default: return "?";
+	}
+}
+
+/*static*/
+const char* MemoryAccounting::eventName( Event event )
+{
+	switch ( event )
+	{
+		case Event::reserve: return "reserve";
+		case Event::unreserve: return "unreserve";
+		case Event::commit: return "commit";
+		case Event::decommit: return "decommit";
+		case Event::reset: return "reset";
+		case Event::reuse: return "reuse";
+		case Event::transferIn: return "transfer in";
+		case Event::transferOut: return "transfer out";
+		default: return "?";
+	}
+}
+
+#ifndef NODECPP_NO_MEMORY_ACCOUNTING
+
+namespace {
+
+	struct alignas(NODECPP_CACHE_LINE_SIZE) TagCounters
+	{
+		std::atomic<size_t> reserved = 0;
+		std::atomic<size_t> committed = 0;
+		std::atomic<size_t> resident = 0;
+		std::atomic<size_t> peakReserved = 0;
+		std::atomic<size_t> peakCommitted = 0;
+	};
+	TagCounters counters[(size_t)(MemoryTag::count)];
+
+	void updatePeak( std::atomic<size_t>& peak, size_t value )
+	{
+		size_t prev = peak.load( std::memory_order_relaxed );
+		while ( value > prev && !peak.compare_exchange_weak( prev, value, std::memory_order_relaxed ) );
+	}
+
+	// Trace ring; an entry is valid for reading iff its seq is (index of the event) + 1, which is set last
+	struct TraceEntry
+	{
+		std::atomic<uint64_t> seq = 0;
+		std::atomic<uint64_t> timeNs = 0;
+		std::atomic<const void*> addr = nullptr;
+		std::atomic<size_t> size = 0;
+		std::atomic<uint32_t> threadHash = 0;
+		std::atomic<MemoryAccounting::Event> event = MemoryAccounting::Event::reserve;
+		std::atomic<MemoryTag> tag = MemoryTag::other;
+	};
+	static_assert( ( MemoryAccounting::traceRingSize & ( MemoryAccounting::traceRingSize - 1 ) ) == 0 );
+	TraceEntry traceRing[MemoryAccounting::traceRingSize];
+	std::atomic<uint64_t> traceNext = 0;
+	std::atomic<bool> traceEnabled = false;
+
+	void trace( MemoryAccounting::Event event, MemoryTag tag, const void* addr, size_t size )
+	{
+		if ( NODECPP_LIKELY( !traceEnabled.load( std::memory_order_relaxed ) ) )
+			return;
+		uint64_t idx = traceNext.fetch_add( 1, std::memory_order_relaxed );
+		TraceEntry& e = traceRing[idx & ( MemoryAccounting::traceRingSize - 1 )];
+		e.seq.store( 0, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+		e.timeNs.store( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count(), std::memory_order_relaxed );
+		e.addr.store( addr, std::memory_order_relaxed );
+		e.size.store( size, std::memory_order_relaxed );
+		e.threadHash.store( (uint32_t)std::hash<std::thread::id>()( std::this_thread::get_id() ), std::memory_order_relaxed );
+		e.event.store( event, std::memory_order_relaxed );
+		e.tag.store( tag, std::memory_order_relaxed );
+		e.seq.store( idx + 1, std::memory_order_release );
+	}
+
+} // anonymous namespace
+
+/*static*/
+MemoryAccounting::Stats MemoryAccounting::getStats( MemoryTag tag )
+{
+	TagCounters& c = counters[(size_t)tag];
+	return Stats{ c.reserved.load( std::memory_order_relaxed ), c.committed.load( std::memory_order_relaxed ), c.resident.load( std::memory_order_relaxed ), 
+		c.peakReserved.load( std::memory_order_relaxed ), c.peakCommitted.load( std::memory_order_relaxed ) };
+}
+
+/*static*/
+MemoryAccounting::Stats MemoryAccounting::getTotalStats()
+{
+	Stats ret = {};
+	for ( size_t i=0; i<(size_t)(MemoryTag::count); ++i )
+	{
+		Stats s = getStats( (MemoryTag)i );
+		ret.reserved += s.reserved;
+		ret.committed += s.committed;
+		ret.resident += s.resident;
+		ret.peakReserved += s.peakReserved;
+		ret.peakCommitted += s.peakCommitted;
+	}
+	return ret;
+}
+
+/*static*/
+void MemoryAccounting::logStats()
+{
+	for ( size_t i=0; i<(size_t)(MemoryTag::count); ++i )
+	{
+		Stats s = getStats( (MemoryTag)i );
+		nodecpp::log::default_log::info( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "memory [{}]: reserved 0x{:x} (peak 0x{:x}), committed 0x{:x} (peak 0x{:x}), resident 0x{:x}", 
+			tagName( (MemoryTag)i ), s.reserved, s.peakReserved, s.committed, s.peakCommitted, s.resident );
+	}
+}
+
+/*static*/
+void MemoryAccounting::enableTrace( bool enable )
+{
+	traceEnabled.store( enable, std::memory_order_relaxed );
+}
+
+/*static*/
+bool MemoryAccounting::isTraceEnabled()
+{
+	return traceEnabled.load( std::memory_order_relaxed );
+}
+
+/*static*/
+void MemoryAccounting::dumpTrace( FILE* f )
+{
+	// entries that are being overwritten while we are here are skipped
+	uint64_t end = traceNext.load( std::memory_order_acquire );
+	uint64_t begin = end > traceRingSize ? end - traceRingSize : 0;
+	for ( uint64_t idx=begin; idx<end; ++idx )
+	{
+		TraceEntry& e = traceRing[idx & ( traceRingSize - 1 )];
+		if ( e.seq.load( std::memory_order_acquire ) != idx + 1 )
+			continue;
+		uint64_t timeNs = e.timeNs.load( std::memory_order_relaxed );
+		const void* addr = e.addr.load( std::memory_order_relaxed );
+		size_t size = e.size.load( std::memory_order_relaxed );
+		uint32_t threadHash = e.threadHash.load( std::memory_order_relaxed );
+		Event event = e.event.load( std::memory_order_relaxed );
+		MemoryTag tag = e.tag.load( std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_acquire );
+		if ( e.seq.load( std::memory_order_relaxed ) != idx + 1 )
+			continue;
+		fprintf( f, "[%llu.%06llu] thread %08x: %-12s %-14s %p 0x%zx\n", (unsigned long long)( timeNs / 1000000000 ), (unsigned long long)( timeNs % 1000000000 / 1000 ), 
+			threadHash, eventName( event ), tagName( tag ), addr, size );
+	}
+}
+
+/*static*/
+void MemoryAccounting::onReserve( MemoryTag tag, const void* addr, size_t size )
+{
+	TagCounters& c = counters[(size_t)tag];
+	updatePeak( c.peakReserved, c.reserved.fetch_add( size, std::memory_order_relaxed ) + size );
+	trace( Event::reserve, tag, addr, size );
+}
+
+/*static*/
+void MemoryAccounting::onUnreserve( MemoryTag tag, const void* addr, size_t size )
+{
+	counters[(size_t)tag].reserved.fetch_sub( size, std::memory_order_relaxed );
+	trace( Event::unreserve, tag, addr, size );
+}
+
+/*static*/
+void MemoryAccounting::onCommit( MemoryTag tag, const void* addr, size_t size )
+{
+	TagCounters& c = counters[(size_t)tag];
+	updatePeak( c.peakCommitted, c.committed.fetch_add( size, std::memory_order_relaxed ) + size );
+	c.resident.fetch_add( size, std::memory_order_relaxed );
+	trace( Event::commit, tag, addr, size );
+}
+
+/*static*/
+void MemoryAccounting::onDecommit( MemoryTag tag, const void* addr, size_t size )
+{
+	TagCounters& c = counters[(size_t)tag];
+	c.committed.fetch_sub( size, std::memory_order_relaxed );
+	c.resident.fetch_sub( size, std::memory_order_relaxed );
+	trace( Event::decommit, tag, addr, size );
+}
+
+/*static*/
+void MemoryAccounting::onReset( MemoryTag tag, const void* addr, size_t size )
+{
+	counters[(size_t)tag].resident.fetch_sub( size, std::memory_order_relaxed );
+	trace( Event::reset, tag, addr, size );
+}
+
+/*static*/
+void MemoryAccounting::onReuse( MemoryTag tag, const void* addr, size_t size )
+{
+	counters[(size_t)tag].resident.fetch_add( size, std::memory_order_relaxed );
+	trace( Event::reuse, tag, addr, size );
+}
+
+/*static*/
+void MemoryAccounting::onTransfer( MemoryTag from, MemoryTag to, const void* addr, size_t size )
+{
+	if ( from == to )
+		return;
+	TagCounters& f = counters[(size_t)from];
+	f.reserved.fetch_sub( size, std::memory_order_relaxed );
+	f.committed.fetch_sub( size, std::memory_order_relaxed );
+	f.resident.fetch_sub( size, std::memory_order_relaxed );
+	TagCounters& t = counters[(size_t)to];
+	updatePeak( t.peakReserved, t.reserved.fetch_add( size, std::memory_order_relaxed ) + size );
+	updatePeak( t.peakCommitted, t.committed.fetch_add( size, std::memory_order_relaxed ) + size );
+	t.resident.fetch_add( size, std::memory_order_relaxed );
+	trace( Event::transferOut, from, addr, size );
+	trace( Event::transferIn, to, addr, size );
+}
+
+#endif // NODECPP_NO_MEMORY_ACCOUNTING
+
+} // namespace nodecpp
@@ -36,6 +36,7 @@
 #if defined(NODECPP_LINUX) || defined(NODECPP_MAC) || defined(NODECPP_ANDROID)
 
 #include <cstdlib>
+#include <cstdio>
 #include <memory>
 #include <cstring>
 #include <limits>
@@ -66,8 +67,54 @@ size_t VirtualMemory::getAllocGranularity()
 	return getPageSize();
 }
 
+static size_t readLargePageSize()
+{
+#if defined(NODECPP_LINUX) || defined(NODECPP_ANDROID)
+	FILE* f = fopen( "/proc/meminfo", "r" );
+	if ( f != nullptr )
+	{
+		char line[128];
+		size_t kb = 0;
+		while ( fgets( line, sizeof(line), f ) != nullptr )
+			if ( sscanf( line, "Hugepagesize: %zu kB", &kb ) == 1 )
+				break;
+		fclose( f );
+		if ( kb != 0 )
+			return kb * 1024;
+	}
+#endif
+	return 0x200000; // 2Mb is what we have with 4Kb base pages on both x64 and arm64
+}
+
+/*static*/
+size_t VirtualMemory::getLargePageSize()
+{
+	static const size_t largePageSize = readLargePageSize();
+	return largePageSize;
+}
 
-void* VirtualMemory::allocate(size_t size)
+/*static*/
+size_t VirtualMemory::getHugePageSize()
+{
+	// 1Gb is available with 4Kb base pages on both x64 and arm64; otherwise we do not go beyond large pages
+	return getPageSize() == 0x1000 ? 0x40000000 : getLargePageSize();
+}
+
+
+// applies prefault and lockInMemory flags to a freshly mapped or committed range
+static void makeResident(void* ptr, size_t size, uint32_t flags)
+{
+	if ( flags & VirtualMemory::lockInMemory )
+	{
+		if ( mlock(ptr, size) == 0 )
+			return; // locked pages are populated, too
+		int e = errno;
+		nodecpp::log::default_log::warning( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "mlock error for 0x{:x} bytes at 0x{:x}, error = {} ({}); pages are not locked", size, (size_t)(ptr), e, strerror(e) );
+	}
+	if ( flags & (VirtualMemory::prefault | VirtualMemory::lockInMemory) )
+		VirtualMemory::PrefaultMemory( ptr, size );
+}
+void* VirtualMemory::implAllocate(size_t size)
 {
 	void* ptr = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
 	if (ptr == (void*)(-1))
@@ -80,7 +127,75 @@ void* VirtualMemory::allocate(size_t size)
 	return ptr;
 }
 
-void VirtualMemory::deallocate(void* ptr, size_t size)
+void* VirtualMemory::implAllocate(size_t size, uint32_t flags, size_t* effectivePageSize)
+{
+	if ( ( flags & (largePages | hugePages) ) == 0 )
+	{
+		if ( effectivePageSize )
+			*effectivePageSize = getPageSize();
+#ifdef MAP_POPULATE
+		if ( flags & prefault )
+		{
+			void* ptr = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_POPULATE, -1, 0);
+			if (ptr == (void*)(-1))
+			{
+				int e = errno;
+				nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "mmap error at allocate({}, 0x{:x}), error = {} ({})", size, flags, e, strerror(e) );
+				throw std::bad_alloc();
+			}
+			makeResident( ptr, size, flags & ~prefault );
+			return ptr;
+		}
+#endif
+		void* ptr = implAllocate( size );
+		makeResident( ptr, size, flags );
+		return ptr;
+	}
+
+	NODECPP_ASSERT(nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, ( flags & (largePages | hugePages) ) != (largePages | hugePages) );
+	size_t requestedPageSize = ( flags & hugePages ) ? getHugePageSize() : getLargePageSize();
+	NODECPP_ASSERT(nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, size % requestedPageSize == 0, "{} vs. {}", size, requestedPageSize );
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+	// explicitly reserved pages (hugetlbfs); would fail if none are configured, which is not an error for us
+	int pageSizeFlag = MAP_HUGETLB | ( __builtin_ctzll( requestedPageSize ) << MAP_HUGE_SHIFT );
+	void* ptr = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|pageSizeFlag, -1, 0);
+	if (ptr != (void*)(-1))
+	{
+		if ( effectivePageSize )
+			*effectivePageSize = requestedPageSize;
+		makeResident( ptr, size, flags );
+		return ptr;
+	}
+#endif // MAP_HUGETLB
+
+	// fallback: regular pages aligned to a large page boundary so that the kernel could back them with transparent large pages
+	size_t alignment = getLargePageSize();
+	size_t fullSize = size + alignment;
+	uint8_t* raw = reinterpret_cast<uint8_t*>( mmap(nullptr, fullSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0) );
+	if (raw == (uint8_t*)(-1))
+	{
+		int e = errno;
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "mmap error at allocate({}, 0x{:x}), error = {} ({})", size, flags, e, strerror(e) );
+		throw std::bad_alloc();
+	}
+	uint8_t* aligned = reinterpret_cast<uint8_t*>( ( reinterpret_cast<uintptr_t>(raw) + alignment - 1 ) & ~( alignment - 1 ) );
+	size_t head = aligned - raw;
+	size_t tail = fullSize - head - size;
+	if ( head )
+		munmap( raw, head );
+	if ( tail )
+		munmap( aligned + size, tail );
+#ifdef MADV_HUGEPAGE
+	madvise( aligned, size, MADV_HUGEPAGE ); // just a hint; failure (say, THP disabled) is not an error
+#endif
+	if ( effectivePageSize )
+		*effectivePageSize = getPageSize(); // transparent large pages are possible, but not guaranteed
+	makeResident( aligned, size, flags );
+	return aligned;
+}
+
+void VirtualMemory::implDeallocate(void* ptr, size_t size)
 {
 	NODECPP_ASSERT(nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, size % 4096 == 0 );
 	int ret = munmap(ptr, size);
@@ -95,7 +210,48 @@ void VirtualMemory::deallocate(void* ptr, size_t size)
 
 
 
-void* VirtualMemory::AllocateAddressSpace(size_t size)
+void VirtualMemory::implAllocateMany(void** out, size_t count, size_t size)
+{
+	if ( count == 0 )
+		return;
+	if ( count > std::numeric_limits<size_t>::max() / size )
+	{
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "size overflow at allocateMany({}, 0x{:x})", count, size );
+		throw std::bad_alloc();
+	}
+	// munmap() of a part of a mapping is fine, so blocks remain independent
+	uint8_t* ptr = reinterpret_cast<uint8_t*>( mmap(nullptr, size * count, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0) );
+	if (ptr == (uint8_t*)(-1))
+	{
+		int e = errno;
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "mmap error at allocateMany({}, 0x{:x}), error = {} ({})", count, size, e, strerror(e) );
+		throw std::bad_alloc();
+	}
+	for ( size_t i=0; i<count; ++i )
+		out[i] = ptr + i * size;
+}
+
+void VirtualMemory::implDeallocateMany(void* const* ptrs, size_t count, size_t size)
+{
+	if ( count == 0 )
+		return;
+	uint8_t* start = reinterpret_cast<uint8_t*>( ptrs[0] );
+	size_t runSize = size;
+	for ( size_t i=1; i<count; ++i )
+	{
+		if ( reinterpret_cast<uint8_t*>( ptrs[i] ) == start + runSize )
+			runSize += size;
+		else
+		{
+			implDeallocate( start, runSize );
+			start = reinterpret_cast<uint8_t*>( ptrs[i] );
+			runSize = size;
+		}
+	}
+	implDeallocate( start, runSize );
+}
+
+void* VirtualMemory::implAllocateAddressSpace(size_t size)
 {
     void * ptr = mmap((void*)0, size, PROT_NONE, MAP_PRIVATE|MAP_ANON, -1, 0);
 	if (ptr == (void*)(-1))
@@ -108,54 +264,137 @@ void* VirtualMemory::AllocateAddressSpace(size_t size)
     return ptr;
 }
  
-void* VirtualMemory::CommitMemory(void* addr, size_t size)
+void* VirtualMemory::implCommitMemory(void* addr, size_t size)
 {
-//    void * ptr = mmap(addr, size, PROT_READ|PROT_WRITE, MAP_FIXED|MAP_SHARED|MAP_ANON, -1, 0);
-    void * ptr = mmap(addr, size, PROT_READ|PROT_WRITE, MAP_FIXED|MAP_PRIVATE|MAP_ANON, -1, 0);
-	if (ptr == (void*)(-1))
+	// the range is already mapped (by AllocateAddressSpace()); pages are populated on first touch
+	int ret = mprotect(addr, size, PROT_READ|PROT_WRITE);
+	if ( ret == -1 )
 	{
 		int e = errno;
-//		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "allocation error at CommitMemory(0x{:x}, 0x{:x}), error = {} ({})", (size_t)(addr), size, e, strerror(e) );
-		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "mmap error at CommitMemory({}), error = {} ({})", size, e, strerror(e) );
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "mprotect error at CommitMemory(0x{:x}, 0x{:x}), error = {} ({})", (size_t)(addr), size, e, strerror(e) );
 		throw std::bad_alloc();
 	}
-//    msync(addr, size, MS_SYNC|MS_INVALIDATE);
-    return ptr;
+	return addr;
 }
- 
-void VirtualMemory::DecommitMemory(void* addr, size_t size)
+
+void* VirtualMemory::implCommitMemory(void* addr, size_t size, uint32_t flags)
 {
-    // instead of unmapping the address, we're just gonna trick 
-    // the TLB to mark this as a new mapped area which, due to 
-    // demand paging, will not be committed until used.
- 
-    void * ptr = mmap(addr, size, PROT_NONE, MAP_FIXED|MAP_PRIVATE|MAP_ANON, -1, 0);
- 	if (ptr == (void*)(-1))
+	void* ptr = implCommitMemory( addr, size );
+#ifdef MADV_HUGEPAGE
+	// pages of a reserved range are already chosen; the best we can do is to ask for transparent large pages
+	if ( flags & (largePages | hugePages) )
+		madvise( ptr, size, MADV_HUGEPAGE );
+#endif
+	makeResident( ptr, size, flags );
+	return ptr;
+}
+
+// madvise() refuses to drop locked pages (EINVAL on Linux); such a range is unlocked and advised again, as dropped pages 
+// cannot stay locked anyway (committing it again with lockInMemory locks it again)
+static int adviseDropping(void* addr, size_t size, int advice)
+{
+	int ret = madvise(addr, size, advice);
+	if ( ret == -1 && errno == EINVAL )
+	{
+		if ( munlock(addr, size) == 0 )
+			ret = madvise(addr, size, advice);
+		else
+			errno = EINVAL;
+	}
+	return ret;
+}
+
+static void decommitRange(void* addr, size_t size, uint32_t flags)
+{
+	if ( flags & VirtualMemory::releaseCommitCharge )
+	{
+		// an inaccessible private mapping is not charged; the next CommitMemory() charges it again
+		void* ptr = mmap(addr, size, PROT_NONE, MAP_FIXED|MAP_PRIVATE|MAP_ANON|MAP_NORESERVE, -1, 0);
+		if (ptr == (void*)(-1))
+		{
+			int e = errno;
+			nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "mmap error at DecommitMemory(0x{:x}, 0x{:x}), error = {} ({})", (size_t)(addr), size, e, strerror(e) );
+			throw std::bad_alloc();
+		}
+		return;
+	}
+	// Physical pages are dropped right away; the mapping itself (and its protection) is left intact, 
+	// so that neither VMAs are split/merged nor the next CommitMemory() has to remap anything.
+	// NOTE: on Mac MADV_DONTNEED is a mere hint that leaves content intact, which is fine for decommitted memory
+	int ret = adviseDropping(addr, size, MADV_DONTNEED);
+	if ( ret == -1 )
 	{
 		int e = errno;
-//		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "allocation error at DecommitMemory(0x{:x}, 0x{:x}), error = {} ({})", (size_t)(addr), size, e, strerror(e) );
-		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "mmap error at DecommitMemory({}), error = {} ({})", size, e, strerror(e) );
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "madvise error at DecommitMemory(0x{:x}, 0x{:x}), error = {} ({})", (size_t)(addr), size, e, strerror(e) );
 		throw std::bad_alloc();
 	}
-   msync(addr, size, MS_SYNC|MS_INVALIDATE);
+}
+
+void VirtualMemory::implDecommitMemory(void* addr, size_t size, uint32_t flags)
+{
+	decommitRange( addr, size, flags );
+}
+
+void VirtualMemory::implDecommitMemory(const MemoryRange* ranges, size_t count, uint32_t flags)
+{
+	if ( count == 0 )
+		return;
+	uint8_t* addr = reinterpret_cast<uint8_t*>( ranges[0].addr );
+	size_t size = ranges[0].size;
+	for ( size_t i=1; i<count; ++i )
+	{
+		if ( reinterpret_cast<uint8_t*>( ranges[i].addr ) == addr + size )
+			size += ranges[i].size;
+		else
+		{
+			decommitRange( addr, size, flags );
+			addr = reinterpret_cast<uint8_t*>( ranges[i].addr );
+			size = ranges[i].size;
+		}
+	}
+	decommitRange( addr, size, flags );
 }
  
-void VirtualMemory::FreeAddressSpace(void* addr, size_t size)
+void VirtualMemory::implFreeAddressSpace(void* addr, size_t size)
 {
-    int ret = msync(addr, size, MS_SYNC);
-  	if ( ret == -1 )
+	int ret = munmap(addr, size);
+ 	if ( ret == -1 )
 	{
 		int e = errno;
-//		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "allocation error at FreeAddressSpace(0x{:x}, 0x{:x}), error = {} ({})", (size_t)(addr), size, e, strerror(e) );
-		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "msync error at FreeAddressSpace({}), error = {} ({})", size, e, strerror(e) );
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "munmap error at FreeAddressSpace(0x{:x}, 0x{:x}), error = {} ({})", (size_t)(addr), size, e, strerror(e) );
 		throw std::bad_alloc();
 	}
-	ret = munmap(addr, size);
- 	if ( ret == -1 )
+}
+
+
+void VirtualMemory::PrefaultMemory(void* addr, size_t size)
+{
+	size_t pageSize = getPageSize();
+	uint8_t* begin = reinterpret_cast<uint8_t*>( reinterpret_cast<uintptr_t>( addr ) & ~( pageSize - 1 ) );
+	size = ( reinterpret_cast<uint8_t*>( addr ) + size - begin + pageSize - 1 ) & ~( pageSize - 1 );
+#ifdef MADV_POPULATE_WRITE
+	if ( madvise(begin, size, MADV_POPULATE_WRITE) == 0 )
+		return;
+	// kernels older than 5.14 (EINVAL); fall back to touching
+#endif
+	// an atomic no-op write faults a page in without any effect on what other threads may be writing there
+	for ( size_t i=0; i<size; i+=pageSize )
+		__atomic_fetch_or( begin + i, (uint8_t)0, __ATOMIC_RELAXED );
+}
+
+void VirtualMemory::implResetMemory(void* addr, size_t size)
+{
+#ifdef MADV_FREE
+	int ret = madvise(addr, size, MADV_FREE);
+	if ( ret == -1 && errno == EINVAL ) // kernels older than 4.5, or locked pages
+		ret = adviseDropping(addr, size, MADV_DONTNEED);
+#else
+	int ret = adviseDropping(addr, size, MADV_DONTNEED);
+#endif
+	if ( ret == -1 )
 	{
 		int e = errno;
-//		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "allocation error at FreeAddressSpace(0x{:x}, 0x{:x}), error = {} ({})", (size_t)(addr), size, e, strerror(e) );
-		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "munmap error at FreeAddressSpace({}), error = {} ({})", size, e, strerror(e) );
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "madvise error at ResetMemory(0x{:x}, 0x{:x}), error = {} ({})", (size_t)(addr), size, e, strerror(e) );
 		throw std::bad_alloc();
 	}
 }
@@ -172,6 +411,7 @@ void VirtualMemory::FreeAddressSpace(void* addr, size_t size)
 #include <limits>
 
 #include <windows.h>
+#include <intrin.h>
 
 using namespace nodecpp;
 
@@ -194,7 +434,46 @@ size_t VirtualMemory::getPageSize()
 }
 
 /*static*/
-void* VirtualMemory::allocate(size_t size)
+size_t VirtualMemory::getLargePageSize()
+{
+	size_t ret = GetLargePageMinimum();
+	return ret != 0 ? ret : 0x200000;
+}
+
+/*static*/
+size_t VirtualMemory::getHugePageSize()
+{
+	// NOTE: 1Gb pages require VirtualAlloc2(); so far we go with large pages instead (see allocate())
+	return getLargePageSize();
+}
+
+// applies prefault and lockInMemory flags to a freshly allocated or committed range
+static void makeResident(void* ptr, size_t size, uint32_t flags)
+{
+	if ( flags & VirtualMemory::lockInMemory )
+	{
+		// NOTE: the number of locked pages is limited by the working set size (see SetProcessWorkingSetSize())
+		if ( VirtualLock(ptr, size) )
+			return;
+		nodecpp::log::default_log::warning( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "Locking memory failed for size {} ({:x}) at address 0x{:x}, error = {}; pages are not locked", size, size, (size_t)ptr, GetLastError() );
+	}
+	if ( flags & (VirtualMemory::prefault | VirtualMemory::lockInMemory) )
+		VirtualMemory::PrefaultMemory( ptr, size );
+}
+
+/*static*/
+void VirtualMemory::PrefaultMemory(void* addr, size_t size)
+{
+	// an atomic no-op write faults a page in without any effect on what other threads may be writing there
+	size_t pageSize = getPageSize();
+	char* begin = reinterpret_cast<char*>( reinterpret_cast<uintptr_t>( addr ) & ~( pageSize - 1 ) );
+	size = ( reinterpret_cast<char*>( addr ) + size - begin + pageSize - 1 ) & ~( pageSize - 1 );
+	for ( size_t i=0; i<size; i+=pageSize )
+		_InterlockedOr8( begin + i, 0 );
+}
+
+/*static*/
+void* VirtualMemory::implAllocate(size_t size)
 {
 	void* ret = VirtualAlloc(0, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
 	if ( ret != nullptr ) // hopefully, likely branch
@@ -208,7 +487,30 @@ void* VirtualMemory::allocate(size_t size)
 }
 
 /*static*/
-void VirtualMemory::deallocate(void* ptr, size_t size)
+void* VirtualMemory::implAllocate(size_t size, uint32_t flags, size_t* effectivePageSize)
+{
+	if ( flags & (largePages | hugePages) )
+	{
+		size_t requestedPageSize = ( flags & hugePages ) ? getHugePageSize() : getLargePageSize();
+		NODECPP_ASSERT(nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, size % requestedPageSize == 0, "{} vs. {}", size, requestedPageSize );
+		// requires SeLockMemoryPrivilege; if not granted, we fall back to regular pages
+		void* ret = VirtualAlloc(0, size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if ( ret != nullptr )
+		{
+			if ( effectivePageSize )
+				*effectivePageSize = requestedPageSize;
+			return ret; // large pages are always resident
+		}
+	}
+	if ( effectivePageSize )
+		*effectivePageSize = getPageSize();
+	void* ret = implAllocate( size );
+	makeResident( ret, size, flags );
+	return ret;
+}
+
+/*static*/
+void VirtualMemory::implDeallocate(void* ptr, size_t size)
 {
 	bool ret = VirtualFree(ptr, 0, MEM_RELEASE);
 	if ( ret ) // hopefully, likely branch
@@ -221,9 +523,24 @@ void VirtualMemory::deallocate(void* ptr, size_t size)
 	}
 }
 
+/*static*/
+void VirtualMemory::implAllocateMany(void** out, size_t count, size_t size)
+{
+	// a region can only be released as a whole; hence, one per block
+	for ( size_t i=0; i<count; ++i )
+		out[i] = implAllocate( size );
+}
+
+/*static*/
+void VirtualMemory::implDeallocateMany(void* const* ptrs, size_t count, size_t size)
+{
+	for ( size_t i=0; i<count; ++i )
+		implDeallocate( ptrs[i], size );
+}
+
 
 /*static*/
-void* VirtualMemory::AllocateAddressSpace(size_t size)
+void* VirtualMemory::implAllocateAddressSpace(size_t size)
 {
     void* ret = VirtualAlloc(NULL, size, MEM_RESERVE , PAGE_NOACCESS);
 	if ( ret != nullptr ) // hopefully, likely branch
@@ -237,7 +554,7 @@ void* VirtualMemory::AllocateAddressSpace(size_t size)
 }
  
 /*static*/
-void* VirtualMemory::CommitMemory(void* addr, size_t size)
+void* VirtualMemory::implCommitMemory(void* addr, size_t size)
 {
 	void* ret = VirtualAlloc(addr, size, MEM_COMMIT, PAGE_READWRITE);
 	if ( ret != nullptr ) // hopefully, likely branch
@@ -249,10 +566,20 @@ void* VirtualMemory::CommitMemory(void* addr, size_t size)
 		return ret;
 	}
 }
+
+/*static*/
+void* VirtualMemory::implCommitMemory(void* addr, size_t size, uint32_t flags)
+{
+	// large pages cannot be committed within a range reserved with regular ones
+	void* ret = implCommitMemory( addr, size );
+	makeResident( ret, size, flags );
+	return ret;
+}
  
 /*static*/
-void VirtualMemory::DecommitMemory(void* addr, size_t size)
+void VirtualMemory::implDecommitMemory(void* addr, size_t size, uint32_t flags)
 {
+	// MEM_DECOMMIT gives the commit charge back, too, whatever flags are
     BOOL ret = VirtualFree((void*)addr, size, MEM_DECOMMIT);
 	if ( ret ) // hopefully, likely branch
 		return;
@@ -265,7 +592,28 @@ void VirtualMemory::DecommitMemory(void* addr, size_t size)
 }
  
 /*static*/
-void VirtualMemory::FreeAddressSpace(void* addr, size_t size)
+void VirtualMemory::implDecommitMemory(const MemoryRange* ranges, size_t count, uint32_t flags)
+{
+	if ( count == 0 )
+		return;
+	uint8_t* addr = reinterpret_cast<uint8_t*>( ranges[0].addr );
+	size_t size = ranges[0].size;
+	for ( size_t i=1; i<count; ++i )
+	{
+		if ( reinterpret_cast<uint8_t*>( ranges[i].addr ) == addr + size )
+			size += ranges[i].size;
+		else
+		{
+			implDecommitMemory( addr, size, flags );
+			addr = reinterpret_cast<uint8_t*>( ranges[i].addr );
+			size = ranges[i].size;
+		}
+	}
+	implDecommitMemory( addr, size, flags );
+}
+ 
+/*static*/
+void VirtualMemory::implFreeAddressSpace(void* addr, size_t size)
 {
     BOOL ret = VirtualFree((void*)addr, 0, MEM_RELEASE);
 	if ( ret ) // hopefully, likely branch
@@ -278,6 +626,20 @@ void VirtualMemory::FreeAddressSpace(void* addr, size_t size)
 	}
 }
 
+/*static*/
+void VirtualMemory::implResetMemory(void* addr, size_t size)
+{
+	void* ret = VirtualAlloc(addr, size, MEM_RESET, PAGE_READWRITE);
+	if ( ret != nullptr ) // hopefully, likely branch
+		return;
+	else
+	{
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "Resetting memory failed for size {} ({:x}) at address 0x{:x}, error = {}", size, size, (size_t)addr, GetLastError() );
+		throw std::bad_alloc();
+		return;
+	}
+}
+
 #elif defined(NODECPP_WASM32) || defined(NODECPP_WASM64)
 
 
@@ -310,7 +672,27 @@ size_t VirtualMemory::getAllocGranularity()
 }
 
 /*static*/
-void* VirtualMemory::allocate(size_t size)
+size_t VirtualMemory::getLargePageSize()
+{
+	return WasmPageSize;
+}
+
+/*static*/
+size_t VirtualMemory::getHugePageSize()
+{
+	return WasmPageSize;
+}
+
+/*static*/
+void* VirtualMemory::implAllocate(size_t size, uint32_t flags, size_t* effectivePageSize)
+{
+	if ( effectivePageSize )
+		*effectivePageSize = WasmPageSize;
+	return implAllocate( size );
+}
+
+/*static*/
+void* VirtualMemory::implAllocate(size_t size)
 {
 	void* ptr = ::malloc( size + WasmPageSize );
 	if (ptr == (void*)(-1))
@@ -327,13 +709,39 @@ void* VirtualMemory::allocate(size_t size)
 }
 
 /*static*/
-void VirtualMemory::deallocate(void* ptr, size_t size)
+void VirtualMemory::implDeallocate(void* ptr, size_t size)
 {
 	NODECPP_ASSERT(nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, size % WasmPageSize == 0 );
 	void* ptrToDelete = (void*)(*((uintptr_t*)ptr - 1));
 	NODECPP_ASSERT(nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, (uintptr_t)ptr - (uintptr_t)ptrToDelete <= WasmPageSize );
 	::free(ptrToDelete);
 }
+
+/*static*/
+void VirtualMemory::implAllocateMany(void** out, size_t count, size_t size)
+{
+	for ( size_t i=0; i<count; ++i )
+		out[i] = implAllocate( size );
+}
+
+/*static*/
+void VirtualMemory::implDeallocateMany(void* const* ptrs, size_t count, size_t size)
+{
+	for ( size_t i=0; i<count; ++i )
+		implDeallocate( ptrs[i], size );
+}
+
+/*static*/
+void VirtualMemory::PrefaultMemory(void* addr, size_t size)
+{
+	// nothing to do: linear memory has no page faults
+}
+
+/*static*/
+void VirtualMemory::implResetMemory(void* addr, size_t size)
+{
+	// nothing to do: memory is never given back
+}
  
 
 
@@ -341,4 +749,124 @@ void VirtualMemory::deallocate(void* ptr, size_t size)
 
 #error unknown/unsupported OS
 
-#endif
\ No newline at end of file
+#endif
+
+
+// OS-independent part: accounting
+
+/*static*/
+void* VirtualMemory::allocate(size_t size, MemoryTag tag)
+{
+	void* ret = implAllocate( size );
+	MemoryAccounting::onReserve( tag, ret, size );
+	MemoryAccounting::onCommit( tag, ret, size );
+	return ret;
+}
+
+/*static*/
+void* VirtualMemory::allocate(size_t size, uint32_t flags, size_t* effectivePageSize, MemoryTag tag)
+{
+	void* ret = implAllocate( size, flags, effectivePageSize );
+	MemoryAccounting::onReserve( tag, ret, size );
+	MemoryAccounting::onCommit( tag, ret, size );
+	return ret;
+}
+
+/*static*/
+void VirtualMemory::deallocate(void* ptr, size_t size, MemoryTag tag)
+{
+	implDeallocate( ptr, size );
+	MemoryAccounting::onDecommit( tag, ptr, size );
+	MemoryAccounting::onUnreserve( tag, ptr, size );
+}
+
+/*static*/
+void VirtualMemory::allocateMany(void** out, size_t count, size_t size, MemoryTag tag)
+{
+	implAllocateMany( out, count, size );
+	if ( count )
+	{
+		MemoryAccounting::onReserve( tag, out[0], count * size );
+		MemoryAccounting::onCommit( tag, out[0], count * size );
+	}
+}
+
+/*static*/
+void VirtualMemory::deallocateMany(void* const* ptrs, size_t count, size_t size, MemoryTag tag)
+{
+	implDeallocateMany( ptrs, count, size );
+	if ( count )
+	{
+		MemoryAccounting::onDecommit( tag, ptrs[0], count * size );
+		MemoryAccounting::onUnreserve( tag, ptrs[0], count * size );
+	}
+}
+
+/*static*/
+void VirtualMemory::ResetMemory(void* addr, size_t size, MemoryTag tag)
+{
+	implResetMemory( addr, size );
+	MemoryAccounting::onReset( tag, addr, size );
+}
+
+#if !defined(NODECPP_WASM32) && !defined(NODECPP_WASM64) // no address space management there
+
+/*static*/
+void* VirtualMemory::AllocateAddressSpace(size_t size, MemoryTag tag)
+{
+	void* ret = implAllocateAddressSpace( size );
+	MemoryAccounting::onReserve( tag, ret, size );
+	return ret;
+}
+
+/*static*/
+void VirtualMemory::FreeAddressSpace(void* addr, size_t size, MemoryTag tag)
+{
+	implFreeAddressSpace( addr, size );
+	MemoryAccounting::onUnreserve( tag, addr, size );
+}
+
+/*static*/
+void* VirtualMemory::CommitMemory(void* addr, size_t size, MemoryTag tag)
+{
+	void* ret = implCommitMemory( addr, size );
+	MemoryAccounting::onCommit( tag, ret, size );
+	return ret;
+}
+
+/*static*/
+void* VirtualMemory::CommitMemory(void* addr, size_t size, uint32_t flags, MemoryTag tag)
+{
+	void* ret = implCommitMemory( addr, size, flags );
+	MemoryAccounting::onCommit( tag, ret, size );
+	return ret;
+}
+
+/*static*/
+void VirtualMemory::DecommitMemory(void* addr, size_t size, MemoryTag tag)
+{
+	DecommitMemory( addr, size, noFlags, tag );
+}
+
+/*static*/
+void VirtualMemory::DecommitMemory(void* addr, size_t size, uint32_t flags, MemoryTag tag)
+{
+	implDecommitMemory( addr, size, flags );
+	MemoryAccounting::onDecommit( tag, addr, size );
+}
+
+/*static*/
+void VirtualMemory::DecommitMemory(const MemoryRange* ranges, size_t count, MemoryTag tag)
+{
+	DecommitMemory( ranges, count, noFlags, tag );
+}
+
+/*static*/
+void VirtualMemory::DecommitMemory(const MemoryRange* ranges, size_t count, uint32_t flags, MemoryTag tag)
+{
+	implDecommitMemory( ranges, count, flags );
+	for ( size_t i=0; i<count; ++i )
+		MemoryAccounting::onDecommit( tag, ranges[i].addr, ranges[i].size );
+}
+
+#endif // !NODECPP_WASM32 && !NODECPP_WASM64
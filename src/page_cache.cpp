@@ -0,0 +1,340 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include "../include/foundation.h"
+#include "../include/page_allocator.h"
+#include "../include/page_cache.h"
+#include "aba_tag_impl.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace nodecpp {
+
+namespace {
+
+	// Lives at the beginning of the first run of a batch while the batch is in a global list
+	struct BatchHeader
+	{
+		BatchHeader* next;
+		size_t runCnt; // including the run that holds this header
+		bool isReset; // all runs but the one holding this header are given back to OS (see PageCache::trim())
+		void* runs[PageCache::batchSize - 1];
+	};
+	static_assert( sizeof( BatchHeader ) <= NODECPP_MINIMUM_CPU_PAGE_SIZE );
+
+	// Batches are never unmapped while being in cache (see aba_tag_impl::TaggedStack)
+	using GlobalBatchList = aba_tag_impl::TaggedStack<BatchHeader, &BatchHeader::next, NODECPP_MINIMUM_CPU_PAGE_SIZE>;
+
+	GlobalBatchList globalLists[PageCache::maxCachedRunPages];
+	std::atomic<size_t> globalCachedBytes = 0;
+	std::atomic<size_t> globalResidentBytes = 0;
+	std::atomic<size_t> highWaterMark = PageCache::defaultHighWaterMark;
+
+	size_t runBytes( size_t pageCnt ) { return pageCnt * VirtualMemory::getPageSize(); }
+
+	void pushBatch( size_t pageCnt, void** runs, size_t cnt )
+	{
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, cnt != 0 && cnt <= PageCache::batchSize );
+		BatchHeader* b = reinterpret_cast<BatchHeader*>( runs[0] );
+		b->runCnt = cnt;
+		b->isReset = false;
+		for ( size_t i=1; i<cnt; ++i )
+			b->runs[i-1] = runs[i];
+		globalLists[pageCnt - 1].push( b, b );
+		size_t bytes = cnt * runBytes( pageCnt );
+		globalCachedBytes.fetch_add( bytes, std::memory_order_relaxed );
+		size_t resident = globalResidentBytes.fetch_add( bytes, std::memory_order_relaxed ) + bytes;
+		if ( resident > highWaterMark.load( std::memory_order_relaxed ) )
+			PageCache::trim();
+	}
+
+	// runs changing hands between the cache and its users are reported to MemoryAccounting in portions of at least 
+	// that many pages (1Mb for 4Kb pages) per thread and tag (or on flush), as reporting each of them would cost more than the rest of acquire()/release()
+	constexpr int64_t accountingGranularity = 0x100;
+
+	struct ThreadCache
+	{
+		struct Bin
+		{
+			size_t cnt;
+			void* runs[PageCache::threadCacheDepth];
+		};
+		Bin bins[PageCache::maxCachedRunPages];
+		int64_t pendingTransfers[(size_t)(MemoryTag::count)]; // pages from the cache to a tag (negative: backwards), not yet reported
+		bool isDestroyed = false; // thread is exiting; whatever is released afterwards goes to global lists directly
+
+		ThreadCache() { memset( bins, 0, sizeof( bins ) ); memset( pendingTransfers, 0, sizeof( pendingTransfers ) ); }
+		~ThreadCache() { flush(); isDestroyed = true; }
+
+		void addTransfer( MemoryTag tag, const void* ptr, int64_t pageCnt )
+		{
+			if ( NODECPP_UNLIKELY( isDestroyed ) )
+			{
+				if ( pageCnt > 0 )
+					MemoryAccounting::onTransfer( MemoryTag::pageCache, tag, ptr, runBytes( pageCnt ) );
+				else
+					MemoryAccounting::onTransfer( tag, MemoryTag::pageCache, ptr, runBytes( -pageCnt ) );
+				return;
+			}
+			int64_t& pending = pendingTransfers[(size_t)tag];
+			pending += pageCnt;
+			if ( NODECPP_UNLIKELY( pending >= accountingGranularity || pending <= -accountingGranularity ) )
+				reportTransfers( tag );
+		}
+
+		void reportTransfers( MemoryTag tag )
+		{
+			int64_t& pending = pendingTransfers[(size_t)tag];
+			if ( pending > 0 )
+				MemoryAccounting::onTransfer( MemoryTag::pageCache, tag, nullptr, runBytes( pending ) );
+			else if ( pending < 0 )
+				MemoryAccounting::onTransfer( tag, MemoryTag::pageCache, nullptr, runBytes( -pending ) );
+			pending = 0;
+		}
+
+		void flush()
+		{
+			for ( size_t i=0; i<(size_t)(MemoryTag::count); ++i )
+				reportTransfers( (MemoryTag)i );
+			for ( size_t i=0; i<PageCache::maxCachedRunPages; ++i )
+			{
+				Bin& bin = bins[i];
+				while ( bin.cnt )
+				{
+					size_t cnt = bin.cnt < PageCache::batchSize ? bin.cnt : PageCache::batchSize;
+					bin.cnt -= cnt;
+					pushBatch( i + 1, bin.runs + bin.cnt, cnt );
+				}
+			}
+		}
+	};
+	thread_local ThreadCache threadCache;
+
+} // anonymous namespace
+
+/*static*/
+void* PageCache::acquire( size_t pageCnt, MemoryTag tag )
+{
+	if ( NODECPP_UNLIKELY( pageCnt == 0 || pageCnt > maxCachedRunPages ) )
+		return VirtualMemory::allocate( runBytes( pageCnt ), tag );
+
+	ThreadCache& tc = threadCache;
+	ThreadCache::Bin& bin = tc.bins[pageCnt - 1];
+	if ( NODECPP_LIKELY( bin.cnt ) )
+	{
+		void* ret = bin.runs[--bin.cnt];
+		tc.addTransfer( tag, ret, pageCnt );
+		return ret;
+	}
+
+	BatchHeader* b = globalLists[pageCnt - 1].pop();
+	if ( b != nullptr )
+	{
+		size_t bytes = b->runCnt * runBytes( pageCnt );
+		globalCachedBytes.fetch_sub( bytes, std::memory_order_relaxed );
+		globalResidentBytes.fetch_sub( b->isReset ? runBytes( pageCnt ) : bytes, std::memory_order_relaxed );
+		if ( b->isReset )
+			MemoryAccounting::onReuse( MemoryTag::pageCache, b, bytes - runBytes( pageCnt ) );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, b->runCnt <= threadCacheDepth );
+		if ( !tc.isDestroyed )
+		{
+			for ( size_t i=1; i<b->runCnt; ++i )
+				bin.runs[bin.cnt++] = b->runs[i-1];
+		}
+		else if ( b->runCnt > 1 )
+			pushBatch( pageCnt, b->runs, b->runCnt - 1 );
+		tc.addTransfer( tag, b, pageCnt );
+		return b;
+	}
+
+	return VirtualMemory::allocate( runBytes( pageCnt ), tag );
+}
+
+/*static*/
+void PageCache::release( void* ptr, size_t pageCnt, MemoryTag tag )
+{
+	if ( NODECPP_UNLIKELY( pageCnt == 0 || pageCnt > maxCachedRunPages ) )
+	{
+		VirtualMemory::deallocate( ptr, runBytes( pageCnt ), tag );
+		return;
+	}
+	ThreadCache& tc = threadCache;
+	tc.addTransfer( tag, ptr, -(int64_t)pageCnt );
+	if ( NODECPP_UNLIKELY( tc.isDestroyed ) )
+	{
+		pushBatch( pageCnt, &ptr, 1 );
+		return;
+	}
+
+	ThreadCache::Bin& bin = tc.bins[pageCnt - 1];
+	if ( NODECPP_UNLIKELY( bin.cnt == threadCacheDepth ) )
+	{
+		// oldest runs go to the global list; most recently used (likely, still hot) ones stay here
+		pushBatch( pageCnt, bin.runs, batchSize );
+		memmove( bin.runs, bin.runs + batchSize, ( threadCacheDepth - batchSize ) * sizeof( void* ) );
+		bin.cnt -= batchSize;
+	}
+	bin.runs[bin.cnt++] = ptr;
+}
+
+/*static*/
+void PageCache::acquireMany( void** out, size_t count, size_t pageCnt, MemoryTag tag )
+{
+	if ( NODECPP_UNLIKELY( pageCnt == 0 || pageCnt > maxCachedRunPages ) )
+	{
+		VirtualMemory::allocateMany( out, count, runBytes( pageCnt ), tag );
+		return;
+	}
+
+	size_t done = 0;
+	ThreadCache::Bin& bin = threadCache.bins[pageCnt - 1];
+	while ( done < count && bin.cnt )
+		out[done++] = bin.runs[--bin.cnt];
+
+	while ( done < count )
+	{
+		BatchHeader* b = globalLists[pageCnt - 1].pop();
+		if ( b == nullptr )
+			break;
+		size_t bytes = b->runCnt * runBytes( pageCnt );
+		globalCachedBytes.fetch_sub( bytes, std::memory_order_relaxed );
+		globalResidentBytes.fetch_sub( b->isReset ? runBytes( pageCnt ) : bytes, std::memory_order_relaxed );
+		if ( b->isReset )
+			MemoryAccounting::onReuse( MemoryTag::pageCache, b, bytes - runBytes( pageCnt ) );
+		size_t i = 1;
+		for ( ; i<b->runCnt && done + 1 < count; ++i ) // leaving a room for the run holding the header
+			out[done++] = b->runs[i-1];
+		size_t leftCnt = b->runCnt - i;
+		if ( leftCnt )
+		{
+			if ( !threadCache.isDestroyed )
+			{
+				for ( ; i<b->runCnt; ++i )
+					bin.runs[bin.cnt++] = b->runs[i-1];
+			}
+			else
+				pushBatch( pageCnt, b->runs + i - 1, leftCnt );
+		}
+		out[done++] = b;
+	}
+
+	if ( done )
+		threadCache.addTransfer( tag, out[0], done * pageCnt );
+	if ( done < count )
+		VirtualMemory::allocateMany( out + done, count - done, runBytes( pageCnt ), tag );
+}
+
+/*static*/
+void PageCache::releaseMany( void* const* ptrs, size_t count, size_t pageCnt, MemoryTag tag )
+{
+	if ( NODECPP_UNLIKELY( pageCnt == 0 || pageCnt > maxCachedRunPages ) )
+	{
+		VirtualMemory::deallocateMany( ptrs, count, runBytes( pageCnt ), tag );
+		return;
+	}
+	if ( count )
+		threadCache.addTransfer( tag, ptrs[0], -(int64_t)( count * pageCnt ) );
+
+	size_t done = 0;
+	if ( NODECPP_LIKELY( !threadCache.isDestroyed ) )
+	{
+		ThreadCache::Bin& bin = threadCache.bins[pageCnt - 1];
+		while ( done < count && bin.cnt < threadCacheDepth )
+			bin.runs[bin.cnt++] = ptrs[done++];
+	}
+	// the rest goes to the global list directly, by whole batches
+	while ( done < count )
+	{
+		void* runs[batchSize];
+		size_t cnt = count - done < batchSize ? count - done : batchSize;
+		memcpy( runs, ptrs + done, cnt * sizeof( void* ) );
+		pushBatch( pageCnt, runs, cnt );
+		done += cnt;
+	}
+}
+
+/*static*/
+void PageCache::flushThreadCache()
+{
+	threadCache.flush();
+}
+
+/*static*/
+void PageCache::setHighWaterMark( size_t bytes )
+{
+	highWaterMark.store( bytes, std::memory_order_relaxed );
+}
+
+/*static*/
+size_t PageCache::getHighWaterMark()
+{
+	return highWaterMark.load( std::memory_order_relaxed );
+}
+
+/*static*/
+void PageCache::trim()
+{
+	// Batches are taken out of a list, all at once, to make sure nobody uses them while we are resetting them;
+	// a run holding a batch header stays resident (otherwise the header could be lost), other runs are reset
+	for ( size_t i=maxCachedRunPages; i>0; --i )
+	{
+		if ( globalResidentBytes.load( std::memory_order_relaxed ) <= highWaterMark.load( std::memory_order_relaxed ) )
+			return;
+		BatchHeader* first = globalLists[i - 1].popAll();
+		if ( first == nullptr )
+			continue;
+		BatchHeader* last = first;
+		for ( BatchHeader* b = first; b != nullptr; b = b->next )
+		{
+			last = b;
+			if ( b->isReset || b->runCnt == 1 )
+				continue;
+			if ( globalResidentBytes.load( std::memory_order_relaxed ) <= highWaterMark.load( std::memory_order_relaxed ) )
+				continue;
+			for ( size_t j=1; j<b->runCnt; ++j )
+				VirtualMemory::ResetMemory( b->runs[j-1], runBytes( i ), MemoryTag::pageCache );
+			b->isReset = true;
+			globalResidentBytes.fetch_sub( ( b->runCnt - 1 ) * runBytes( i ), std::memory_order_relaxed );
+		}
+		globalLists[i - 1].push( first, last );
+	}
+}
+
+/*static*/
+size_t PageCache::cachedBytes()
+{
+	return globalCachedBytes.load( std::memory_order_relaxed );
+}
+
+/*static*/
+size_t PageCache::residentCachedBytes()
+{
+	return globalResidentBytes.load( std::memory_order_relaxed );
+}
+
+} // namespace nodecpp
@@ -0,0 +1,576 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include "../include/foundation.h"
+#include "../include/page_allocator.h"
+#include "../include/page_pool.h"
+#include "aba_tag_impl.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace nodecpp {
+
+namespace {
+
+	// Lives at the beginning of a free page; nextBatch and cnt are meaningful only for a first page of a batch in a global or return list
+	struct FreePage
+	{
+		FreePage* next;
+		FreePage* nextBatch;
+		size_t cnt; // pages in the batch, including this one
+	};
+	static_assert( sizeof( FreePage ) <= PagePool::pageSize );
+
+	// Batches are linked by 'nextBatch' of their first pages. Pages are never unmapped, so reading 'nextBatch' of a batch 
+	// that has just been popped by another thread is safe
+	template<size_t alignment>
+	using GlobalBatchList = aba_tag_impl::TaggedStack<FreePage, &FreePage::nextBatch, alignment>;
+
+	GlobalBatchList<PagePool::pageSize> globalList;
+	std::atomic<size_t> globalPageCnt = 0;
+	std::atomic<size_t> chunkBytes = 0;
+
+	void pushBatch( FreePage* first, size_t cnt )
+	{
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, first != nullptr && cnt != 0 );
+		first->cnt = cnt;
+		globalList.push( first );
+		globalPageCnt.fetch_add( cnt, std::memory_order_relaxed );
+	}
+
+	// links pages of [begin, end) into batches of up to batchPages and pushes them to the global list
+	void pushRange( uint8_t* begin, uint8_t* end )
+	{
+		while ( begin < end )
+		{
+			size_t cnt = ( end - begin ) / PagePool::pageSize;
+			if ( cnt > PagePool::batchPages )
+				cnt = PagePool::batchPages;
+			FreePage* first = reinterpret_cast<FreePage*>( begin );
+			for ( size_t i=0; i<cnt; ++i )
+				reinterpret_cast<FreePage*>( begin + i * PagePool::pageSize )->next = i + 1 < cnt ? reinterpret_cast<FreePage*>( begin + ( i + 1 ) * PagePool::pageSize ) : nullptr;
+			pushBatch( first, cnt );
+			begin += cnt * PagePool::pageSize;
+		}
+	}
+
+	// Cells: pages split into cells are never turned back into pages; free cells are kept by heaps (by hot and cold lists, 
+	// as pages are) and by a global list, regardless of where they come from
+	constexpr size_t cellsPerPage = PagePool::pageSize / PagePool::cellSize;
+	GlobalBatchList<PagePool::cellSize> globalCellList;
+
+	// links cells of a page but the first skip ones
+	FreePage* splitPage( uint8_t* page, size_t skip )
+	{
+		for ( size_t i=skip; i<cellsPerPage; ++i )
+			reinterpret_cast<FreePage*>( page + i * PagePool::cellSize )->next = i + 1 < cellsPerPage ? reinterpret_cast<FreePage*>( page + ( i + 1 ) * PagePool::cellSize ) : nullptr;
+		return reinterpret_cast<FreePage*>( page + skip * PagePool::cellSize );
+	}
+
+	struct CellCache
+	{
+		FreePage* hot = nullptr;
+		size_t hotCnt = 0;
+		FreePage* cold = nullptr; // either empty or exactly cellBatch cells
+		size_t coldCnt = 0;
+	};
+
+	struct Heap;
+
+	// Lives in the first page of a chunk
+	struct ChunkHeader
+	{
+		Heap* owner; // nullptr for chunks obtained by exiting threads; their pages are released to the global list
+		std::atomic<uint32_t> extraRefs[PagePool::chunkSize / PagePool::pageSize]; // holders of a page but one (see PagePool::addRef())
+	};
+	static_assert( sizeof( ChunkHeader ) <= PagePool::pageSize );
+
+	ChunkHeader* chunkOf( const void* page ) { return reinterpret_cast<ChunkHeader*>( reinterpret_cast<uintptr_t>( page ) & ~( PagePool::chunkSize - 1 ) ); }
+	std::atomic<uint32_t>& extraRefsOf( const void* page ) { return chunkOf( page )->extraRefs[( reinterpret_cast<uintptr_t>( page ) & ( PagePool::chunkSize - 1 ) ) / PagePool::pageSize]; }
+
+	// whoever sees no extra holders (either before or as a result of decrementing) is the last holder of a page
+	NODECPP_NOINLINE
+	bool releaseExtraRef( std::atomic<uint32_t>& extraRefs )
+	{
+		if ( extraRefs.fetch_sub( 1, std::memory_order_acq_rel ) != 0 )
+			return false;
+		extraRefs.store( 0, std::memory_order_relaxed );
+		return true;
+	}
+
+	// Chunks are committed one by one within regions of regionChunks chunks; a region is reserved with a spare chunk to align chunks
+	constexpr size_t regionChunks = 64;
+	std::mutex regionMx;
+	uint8_t* regionPos = nullptr;
+	uint8_t* regionEnd = nullptr;
+
+	uint8_t* allocateChunk( Heap* owner )
+	{
+		uint8_t* chunk;
+		{
+			std::unique_lock<std::mutex> lock( regionMx );
+			if ( regionPos == regionEnd )
+			{
+				size_t sz = ( regionChunks + 1 ) * PagePool::chunkSize;
+#if defined(NODECPP_WASM32) || defined(NODECPP_WASM64)
+				uintptr_t region = reinterpret_cast<uintptr_t>( VirtualMemory::allocate( sz, MemoryTag::message ) );
+#else
+				uintptr_t region = reinterpret_cast<uintptr_t>( VirtualMemory::AllocateAddressSpace( sz, MemoryTag::message ) );
+#endif
+				regionPos = reinterpret_cast<uint8_t*>( ( region + PagePool::chunkSize - 1 ) & ~( PagePool::chunkSize - 1 ) );
+				regionEnd = regionPos + regionChunks * PagePool::chunkSize;
+			}
+			chunk = regionPos;
+			regionPos += PagePool::chunkSize;
+		}
+#if !defined(NODECPP_WASM32) && !defined(NODECPP_WASM64)
+		VirtualMemory::CommitMemory( chunk, PagePool::chunkSize, MemoryTag::message );
+#endif
+		chunkBytes.fetch_add( PagePool::chunkSize, std::memory_order_relaxed );
+		ChunkHeader* header = reinterpret_cast<ChunkHeader*>( chunk );
+		header->owner = owner;
+		for ( auto& r : header->extraRefs )
+			r.store( 0, std::memory_order_relaxed );
+		return chunk;
+	}
+
+	// pages released by this thread to some other heap, not yet sent
+	struct Outbox
+	{
+		Heap* owner;
+		FreePage* first;
+		size_t cnt;
+	};
+	constexpr size_t outboxCnt = 8;
+
+	struct alignas(NODECPP_CACHE_LINE_SIZE) Heap
+	{
+		// used by the owning thread only
+		FreePage* hot = nullptr; // pages are taken from and released to this list
+		size_t hotCnt = 0;
+		FreePage* cold = nullptr; // either empty or exactly batchPages pages; goes to the global list when hot overflows once again
+		size_t coldCnt = 0;
+		uint8_t* freshBegin = nullptr; // not yet used part of the last chunk
+		uint8_t* freshEnd = nullptr;
+		FreePage* returnedBatches = nullptr; // taken from 'returned', but not used yet
+		Outbox outboxes[outboxCnt] = {};
+		CellCache cells;
+		Heap* nextAbandoned = nullptr;
+
+		// batches are pushed here by other threads, and are taken all at once by the owner
+		alignas(NODECPP_CACHE_LINE_SIZE) std::atomic<FreePage*> returned = nullptr;
+
+		struct DetachedTag {};
+		Heap() {}
+		Heap( DetachedTag ) { cells.hotCnt = PagePool::cellBatch; } // to direct releaseCell() to its slow path
+	};
+
+	// heaps are never deleted (chunks keep pointing to them); a heap of an exited thread is given to the next new thread
+	std::mutex heapsMx;
+	Heap* abandonedHeaps = nullptr;
+
+	// used by threads whose ThreadCache is already destroyed; it never owns chunks and never keeps pages
+	Heap detachedHeap( Heap::DetachedTag{} );
+
+	void sendBatch( Heap* owner, FreePage* first, size_t cnt )
+	{
+		first->cnt = cnt;
+		FreePage* h = owner->returned.load( std::memory_order_relaxed );
+		do {
+			first->nextBatch = h;
+		} while ( !owner->returned.compare_exchange_weak( h, first, std::memory_order_release, std::memory_order_relaxed ) );
+	}
+
+	void flushOutbox( Outbox& ob )
+	{
+		if ( ob.cnt )
+			sendBatch( ob.owner, ob.first, ob.cnt );
+		ob.owner = nullptr;
+		ob.first = nullptr;
+		ob.cnt = 0;
+	}
+
+	Outbox& outboxFor( Heap& h, Heap* owner )
+	{
+		return h.outboxes[ ( reinterpret_cast<uintptr_t>( owner ) / alignof( Heap ) ) % outboxCnt ];
+	}
+
+	// refills an empty hot list by a batch returned by other threads, if any
+	bool takeReturned( Heap& h )
+	{
+		if ( h.returnedBatches == nullptr )
+		{
+			if ( h.returned.load( std::memory_order_relaxed ) == nullptr )
+				return false;
+			h.returnedBatches = h.returned.exchange( nullptr, std::memory_order_acquire );
+		}
+		FreePage* b = h.returnedBatches;
+		h.returnedBatches = b->nextBatch;
+		h.hot = b;
+		h.hotCnt = b->cnt;
+		return true;
+	}
+
+	void flushHeap( Heap& h )
+	{
+		for ( auto& ob : h.outboxes )
+			flushOutbox( ob );
+		CellCache& cc = h.cells;
+		if ( cc.cold != nullptr )
+		{
+			cc.cold->cnt = cc.coldCnt;
+			globalCellList.push( cc.cold );
+		}
+		if ( cc.hot != nullptr )
+		{
+			cc.hot->cnt = cc.hotCnt;
+			globalCellList.push( cc.hot );
+		}
+		cc = CellCache();
+
+		// most recently used pages go last, to be the first to be reused
+		FreePage* hot = h.hot;
+		size_t hotCnt = h.hotCnt;
+		pushRange( h.freshBegin, h.freshEnd );
+		while ( takeReturned( h ) )
+			pushBatch( h.hot, h.hotCnt );
+		if ( h.cold != nullptr )
+			pushBatch( h.cold, h.coldCnt );
+		if ( hot != nullptr )
+			pushBatch( hot, hotCnt );
+		h.freshBegin = h.freshEnd = nullptr;
+		h.hot = h.cold = nullptr;
+		h.hotCnt = h.coldCnt = 0;
+	}
+
+	struct ThreadCache
+	{
+		Heap* heap;
+
+		ThreadCache()
+		{
+			{
+				std::unique_lock<std::mutex> lock( heapsMx );
+				heap = abandonedHeaps;
+				if ( heap != nullptr )
+					abandonedHeaps = heap->nextAbandoned;
+			}
+			if ( heap == nullptr )
+				heap = new Heap;
+		}
+		~ThreadCache()
+		{
+			// pages released after this point go to their owners or to the global list directly
+			Heap* h = heap;
+			heap = &detachedHeap;
+			flushHeap( *h );
+			std::unique_lock<std::mutex> lock( heapsMx );
+			h->nextAbandoned = abandonedHeaps;
+			abandonedHeaps = h;
+		}
+	};
+	thread_local ThreadCache threadCache;
+
+	void* acquirePageDetached()
+	{
+		FreePage* b = globalList.pop();
+		if ( b != nullptr )
+		{
+			globalPageCnt.fetch_sub( b->cnt, std::memory_order_relaxed );
+			if ( b->cnt > 1 )
+				pushBatch( b->next, b->cnt - 1 );
+			return b;
+		}
+		uint8_t* chunk = allocateChunk( nullptr );
+		pushRange( chunk + 2 * PagePool::pageSize, chunk + PagePool::chunkSize );
+		return chunk + PagePool::pageSize;
+	}
+
+	NODECPP_NOINLINE
+	void* acquirePageSlow( Heap& h )
+	{
+		if ( NODECPP_UNLIKELY( &h == &detachedHeap ) )
+			return acquirePageDetached();
+
+		if ( h.cold != nullptr )
+		{
+			h.hot = h.cold;
+			h.hotCnt = h.coldCnt;
+			h.cold = nullptr;
+			h.coldCnt = 0;
+		}
+		else if ( !takeReturned( h ) )
+		{
+			if ( h.freshBegin < h.freshEnd )
+			{
+				void* ret = h.freshBegin;
+				h.freshBegin += PagePool::pageSize;
+				return ret;
+			}
+
+			FreePage* b = globalList.pop();
+			if ( b != nullptr )
+			{
+				globalPageCnt.fetch_sub( b->cnt, std::memory_order_relaxed );
+				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, b->cnt <= PagePool::batchPages );
+				h.hot = b;
+				h.hotCnt = b->cnt;
+			}
+			else
+			{
+				uint8_t* chunk = allocateChunk( &h );
+				h.freshBegin = chunk + 2 * PagePool::pageSize;
+				h.freshEnd = chunk + PagePool::chunkSize;
+				return chunk + PagePool::pageSize;
+			}
+		}
+
+		FreePage* p = h.hot;
+		h.hot = p->next;
+		--h.hotCnt;
+		return p;
+	}
+
+	NODECPP_NOINLINE
+	void releasePageSlow( Heap& h, Heap* owner, FreePage* p )
+	{
+		if ( owner == &h )
+		{
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, h.hotCnt == PagePool::batchPages );
+			if ( h.cold != nullptr )
+				pushBatch( h.cold, h.coldCnt );
+			h.cold = h.hot;
+			h.coldCnt = h.hotCnt;
+			p->next = nullptr;
+			h.hot = p;
+			h.hotCnt = 1;
+			return;
+		}
+
+		p->next = nullptr;
+		if ( owner == nullptr )
+			pushBatch( p, 1 );
+		else if ( &h == &detachedHeap )
+			sendBatch( owner, p, 1 );
+		else
+		{
+			Outbox& ob = outboxFor( h, owner );
+			if ( ob.owner != owner )
+			{
+				flushOutbox( ob );
+				ob.owner = owner;
+			}
+			p->next = ob.first;
+			ob.first = p;
+			if ( ++ob.cnt == PagePool::remoteBatchPages )
+				flushOutbox( ob );
+		}
+	}
+
+	NODECPP_NOINLINE
+	void* acquireCellSlow( Heap& h )
+	{
+		CellCache& cc = h.cells;
+		if ( cc.cold != nullptr )
+		{
+			cc.hot = cc.cold;
+			cc.hotCnt = cc.coldCnt;
+			cc.cold = nullptr;
+			cc.coldCnt = 0;
+		}
+		else
+		{
+			FreePage* b = globalCellList.pop();
+			if ( b != nullptr && &h == &detachedHeap )
+			{
+				if ( b->cnt > 1 )
+				{
+					b->next->cnt = b->cnt - 1;
+					globalCellList.push( b->next );
+				}
+				return b;
+			}
+			if ( b != nullptr )
+			{
+				cc.hot = b;
+				cc.hotCnt = b->cnt;
+			}
+			else
+			{
+				uint8_t* page = reinterpret_cast<uint8_t*>( PagePool::acquirePage() );
+				FreePage* rest = splitPage( page, 1 );
+				if ( &h == &detachedHeap )
+				{
+					rest->cnt = cellsPerPage - 1;
+					globalCellList.push( rest );
+				}
+				else
+				{
+					cc.hot = rest;
+					cc.hotCnt = cellsPerPage - 1;
+				}
+				return page;
+			}
+		}
+		FreePage* c = cc.hot;
+		cc.hot = c->next;
+		--cc.hotCnt;
+		return c;
+	}
+
+	NODECPP_NOINLINE
+	void releaseCellSlow( Heap& h, FreePage* c )
+	{
+		CellCache& cc = h.cells;
+		c->next = nullptr;
+		if ( &h == &detachedHeap )
+		{
+			c->cnt = 1;
+			globalCellList.push( c );
+			return;
+		}
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, cc.hotCnt == PagePool::cellBatch );
+		if ( cc.cold != nullptr )
+		{
+			cc.cold->cnt = cc.coldCnt;
+			globalCellList.push( cc.cold );
+		}
+		cc.cold = cc.hot;
+		cc.coldCnt = cc.hotCnt;
+		cc.hot = c;
+		cc.hotCnt = 1;
+	}
+
+} // anonymous namespace
+
+/*static*/
+void* PagePool::acquirePage()
+{
+	Heap& h = *threadCache.heap;
+	FreePage* p = h.hot;
+	if ( NODECPP_LIKELY( p != nullptr ) )
+	{
+		h.hot = p->next;
+		--h.hotCnt;
+		return p;
+	}
+	return acquirePageSlow( h );
+}
+
+/*static*/
+void PagePool::releasePage( void* page )
+{
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, page != nullptr && ( reinterpret_cast<uintptr_t>( page ) & ( pageSize - 1 ) ) == 0 );
+	Heap& h = *threadCache.heap;
+	FreePage* p = reinterpret_cast<FreePage*>( page );
+	std::atomic<uint32_t>& extraRefs = extraRefsOf( p );
+	if ( NODECPP_UNLIKELY( extraRefs.load( std::memory_order_acquire ) != 0 ) && !releaseExtraRef( extraRefs ) )
+		return;
+	Heap* owner = chunkOf( p )->owner;
+	if ( NODECPP_LIKELY( owner == &h && h.hotCnt < batchPages ) )
+	{
+		p->next = h.hot;
+		h.hot = p;
+		++h.hotCnt;
+		return;
+	}
+	releasePageSlow( h, owner, p );
+}
+
+/*static*/
+void* PagePool::acquireCell()
+{
+	Heap& h = *threadCache.heap;
+	CellCache& cc = h.cells;
+	FreePage* c = cc.hot;
+	if ( NODECPP_LIKELY( c != nullptr ) )
+	{
+		cc.hot = c->next;
+		--cc.hotCnt;
+		return c;
+	}
+	return acquireCellSlow( h );
+}
+
+/*static*/
+void PagePool::releaseCell( void* cell )
+{
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, cell != nullptr && ( reinterpret_cast<uintptr_t>( cell ) & ( cellSize - 1 ) ) == 0 );
+	Heap& h = *threadCache.heap;
+	CellCache& cc = h.cells;
+	FreePage* c = reinterpret_cast<FreePage*>( cell );
+	if ( NODECPP_LIKELY( cc.hotCnt < cellBatch ) )
+	{
+		c->next = cc.hot;
+		cc.hot = c;
+		++cc.hotCnt;
+		return;
+	}
+	releaseCellSlow( h, c );
+}
+
+/*static*/
+void PagePool::addRef( void* page )
+{
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, page != nullptr && ( reinterpret_cast<uintptr_t>( page ) & ( pageSize - 1 ) ) == 0 );
+	extraRefsOf( page ).fetch_add( 1, std::memory_order_relaxed );
+}
+
+/*static*/
+bool PagePool::isShared( const void* page )
+{
+	return extraRefsOf( page ).load( std::memory_order_acquire ) != 0;
+}
+
+/*static*/
+void PagePool::flushThreadCache()
+{
+	Heap& h = *threadCache.heap;
+	if ( &h != &detachedHeap )
+		flushHeap( h );
+}
+
+/*static*/
+bool PagePool::isOwnedByCallingThread( const void* page )
+{
+	return chunkOf( page )->owner == threadCache.heap;
+}
+
+/*static*/
+size_t PagePool::reservedBytes()
+{
+	return chunkBytes.load( std::memory_order_relaxed );
+}
+
+/*static*/
+size_t PagePool::globalCachedPages()
+{
+	return globalPageCnt.load( std::memory_order_relaxed );
+}
+
+} // namespace nodecpp
@@ -0,0 +1,304 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include "../include/foundation.h"
+#include "../include/memory_accounting.h"
+#include "../include/shm_page_pool.h"
+#include "aba_tag_impl.h"
+
+#include <new>
+
+#ifndef NODECPP_WINDOWS
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+namespace nodecpp {
+
+uint8_t* ShmPagePool::base_ = nullptr;
+
+namespace {
+
+	constexpr uint64_t regionMagic = 0x4d48535050434e4eull;
+	// A head of the free list is an offset of a page with an ABA counter in lower (below pageSize) and upper bits; 
+	// as a peer process may be stopped for indefinitely long while taking a page, the counter is 36 bits wide, 
+	// which leaves 40 bits (1Tb) for the size of a region
+	constexpr size_t freeHeadUpperTagBits = 24;
+	using FreeHeadTag = aba_tag_impl::AbaTag<uint64_t, ShmPagePool::pageSize, freeHeadUpperTagBits>;
+	constexpr uint64_t maxRegionSize = uint64_t(1) << ( 64 - freeHeadUpperTagBits );
+
+	// Lives at the beginning of a region; pages start right after it
+	struct RegionHeader
+	{
+		uint64_t magic;
+		uint64_t size;
+		alignas(NODECPP_CACHE_LINE_SIZE) std::atomic<uint64_t> freeHead; // offset of the first free page, and a counter (see FreeHeadTag)
+		alignas(NODECPP_CACHE_LINE_SIZE) std::atomic<uint64_t> freshPos; // offset of the first page that has never been used
+		std::atomic<uint64_t> usedPages;
+		ShmRing rings[ShmPagePool::ringCnt];
+	};
+	constexpr size_t firstPageOffset = ( sizeof( RegionHeader ) + ShmPagePool::pageSize - 1 ) & ~( ShmPagePool::pageSize - 1 );
+
+	// Lives at the beginning of a free page
+	struct FreePage
+	{
+		uint64_t next; // offset
+	};
+
+	size_t mappedSize = 0;
+
+	RegionHeader& header()
+	{
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, ShmPagePool::isAttached() );
+		return *reinterpret_cast<RegionHeader*>( ShmPagePool::base() );
+	}
+
+#ifndef NODECPP_WINDOWS
+	[[noreturn]] void reportError( const char* what, const char* name, size_t size )
+	{
+		int e = errno;
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "{} error at a shared region ({}, 0x{:x} bytes), error = {} ({})", what, name != nullptr ? name : "anonymous", size, e, strerror(e) );
+		throw std::bad_alloc();
+	}
+
+	uint8_t* mapRegion( int fd, size_t size )
+	{
+		void* ptr = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+		if ( ptr == MAP_FAILED )
+			reportError( "mmap", nullptr, size );
+		MemoryAccounting::onReserve( MemoryTag::message, ptr, size );
+		MemoryAccounting::onCommit( MemoryTag::message, ptr, size );
+		return reinterpret_cast<uint8_t*>( ptr );
+	}
+
+	void unmapRegion( uint8_t* base, size_t size )
+	{
+		MemoryAccounting::onDecommit( MemoryTag::message, base, size );
+		MemoryAccounting::onUnreserve( MemoryTag::message, base, size );
+		munmap( base, size );
+	}
+#endif
+
+} // anonymous namespace
+
+#ifndef NODECPP_WINDOWS
+
+/*static*/
+int ShmPagePool::create( size_t size, const char* name )
+{
+	size &= ~( pageSize - 1 );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, size > firstPageOffset, "{} vs. {}", size, firstPageOffset );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, size <= maxRegionSize, "0x{:x} vs. 0x{:x}", size, maxRegionSize );
+	int fd;
+	if ( name != nullptr )
+		fd = shm_open( name, O_CREAT | O_EXCL | O_RDWR, 0600 );
+	else
+	{
+#ifdef NODECPP_LINUX
+		fd = memfd_create( "nodecpp_shm_page_pool", 0 );
+#else
+		// an object that is unlinked right away is as anonymous as a memfd
+		char tmpName[64];
+		snprintf( tmpName, sizeof(tmpName), "/nodecpp_shm_%d_%p", (int)getpid(), (void*)&mappedSize );
+		fd = shm_open( tmpName, O_CREAT | O_EXCL | O_RDWR, 0600 );
+		if ( fd != -1 )
+			shm_unlink( tmpName );
+#endif
+	}
+	if ( fd == -1 )
+		reportError( "shm_open/memfd_create", name, size );
+	if ( ftruncate( fd, size ) == -1 )
+	{
+		close( fd );
+		reportError( "ftruncate", name, size );
+	}
+
+	uint8_t* base = mapRegion( fd, size );
+	RegionHeader* h = new ( base ) RegionHeader;
+	h->size = size;
+	h->freeHead.store( 0, std::memory_order_relaxed );
+	h->freshPos.store( firstPageOffset, std::memory_order_relaxed );
+	h->usedPages.store( 0, std::memory_order_relaxed );
+	for ( auto& r : h->rings )
+		r.init();
+	std::atomic_thread_fence( std::memory_order_release );
+	h->magic = regionMagic;
+
+	detach();
+	base_ = base;
+	mappedSize = size;
+	return fd;
+}
+
+/*static*/
+void ShmPagePool::attach( int fd )
+{
+	struct stat st;
+	if ( fstat( fd, &st ) == -1 )
+		reportError( "fstat", nullptr, 0 );
+	size_t size = (size_t)st.st_size;
+	if ( size <= firstPageOffset )
+	{
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "attaching to a shared region of 0x{:x} bytes, which is not a page pool", size );
+		throw std::bad_alloc();
+	}
+	// the new mapping is made before the current one is unmapped, so that its address is different (say, in a child attaching to the region it has inherited)
+	uint8_t* base = mapRegion( fd, size );
+	const RegionHeader* h = reinterpret_cast<const RegionHeader*>( base );
+	if ( h->magic != regionMagic || h->size != size )
+	{
+		unmapRegion( base, size );
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "attaching to a shared region of 0x{:x} bytes, which is not a page pool", size );
+		throw std::bad_alloc();
+	}
+	detach();
+	base_ = base;
+	mappedSize = size;
+}
+
+/*static*/
+int ShmPagePool::attach( const char* name )
+{
+	int fd = shm_open( name, O_RDWR, 0 );
+	if ( fd == -1 )
+		reportError( "shm_open", name, 0 );
+	attach( fd );
+	return fd;
+}
+
+/*static*/
+void ShmPagePool::detach()
+{
+	if ( base_ == nullptr )
+		return;
+	unmapRegion( base_, mappedSize );
+	base_ = nullptr;
+	mappedSize = 0;
+}
+
+/*static*/
+void ShmPagePool::remove( const char* name )
+{
+	shm_unlink( name );
+}
+
+#else
+
+/*static*/
+int ShmPagePool::create( size_t size, const char* name )
+{
+	nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "shared page pools are not supported on this platform ({}, 0x{:x} bytes)", name != nullptr ? name : "anonymous", size );
+	throw std::bad_alloc();
+}
+
+/*static*/
+void ShmPagePool::attach( int fd )
+{
+	nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "shared page pools are not supported on this platform (fd {})", fd );
+	throw std::bad_alloc();
+}
+
+/*static*/
+int ShmPagePool::attach( const char* name )
+{
+	nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "shared page pools are not supported on this platform ({})", name );
+	throw std::bad_alloc();
+}
+
+/*static*/
+void ShmPagePool::detach() {}
+
+/*static*/
+void ShmPagePool::remove( const char* ) {}
+
+#endif // NODECPP_WINDOWS
+
+/*static*/
+void* ShmPagePool::acquirePage()
+{
+	RegionHeader& h = header();
+	uint64_t head = h.freeHead.load( std::memory_order_acquire );
+	while ( FreeHeadTag::value( head ) != 0 )
+	{
+		// pages are never unmapped while attached, so reading 'next' of a page that has just been taken by another process is safe
+		uint64_t next = reinterpret_cast<FreePage*>( base_ + FreeHeadTag::value( head ) )->next;
+		if ( h.freeHead.compare_exchange_weak( head, FreeHeadTag::make( next, head ), std::memory_order_acquire, std::memory_order_acquire ) )
+		{
+			h.usedPages.fetch_add( 1, std::memory_order_relaxed );
+			return base_ + FreeHeadTag::value( head );
+		}
+	}
+	uint64_t pos = h.freshPos.fetch_add( pageSize, std::memory_order_relaxed );
+	if ( pos + pageSize > h.size )
+	{
+		nodecpp::log::default_log::error( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "shared region of 0x{:x} bytes exhausted", h.size );
+		throw std::bad_alloc();
+	}
+	h.usedPages.fetch_add( 1, std::memory_order_relaxed );
+	return base_ + pos;
+}
+
+/*static*/
+void ShmPagePool::releasePage( void* page )
+{
+	uint64_t offset = toOffset( page );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::pedantic, offset >= firstPageOffset && offset < mappedSize && FreeHeadTag::fits( offset ), "0x{:x}", offset );
+	RegionHeader& h = header();
+	h.usedPages.fetch_sub( 1, std::memory_order_relaxed );
+	FreePage* fp = reinterpret_cast<FreePage*>( page );
+	uint64_t head = h.freeHead.load( std::memory_order_relaxed );
+	do
+	{
+		fp->next = FreeHeadTag::value( head );
+	}
+	while ( !h.freeHead.compare_exchange_weak( head, FreeHeadTag::make( offset, head ), std::memory_order_release, std::memory_order_relaxed ) );
+}
+
+/*static*/
+ShmRing& ShmPagePool::ring( size_t idx )
+{
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, idx < ringCnt, "{} vs. {}", idx, ringCnt );
+	return header().rings[idx];
+}
+
+/*static*/
+size_t ShmPagePool::usedPages()
+{
+	return header().usedPages.load( std::memory_order_relaxed );
+}
+
+/*static*/
+size_t ShmPagePool::totalPages()
+{
+	return ( header().size - firstPageOffset ) / pageSize;
+}
+
+} // namespace nodecpp
@@ -32,6 +32,7 @@ namespace nodecpp::error {
 	const std_error_domain std_error_domain_obj;
 
 	const nodecpp::error::system_error bad_address( nodecpp::error::errc::bad_address );
+	const nodecpp::error::system_error bad_message( nodecpp::error::errc::bad_message );
 	const nodecpp::error::system_error file_exists( nodecpp::error::errc::file_exists );
 	const nodecpp::error::system_error no_such_file_or_directory( nodecpp::error::errc::no_such_file_or_directory );
 	const nodecpp::error::system_error not_enough_memory( nodecpp::error::errc::not_enough_memory );
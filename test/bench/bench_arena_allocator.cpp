@@ -0,0 +1,85 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include <foundation.h>
+#include <arena_allocator.h>
+#include <stdlib.h>
+#include <vector>
+#include "bench.h"
+
+namespace nodecpp::bench {
+
+	// "per-request scratch memory": a number of small allocations of varying sizes, all freed at the end of a request
+	static constexpr size_t allocsPerRequest = 2000;
+
+	static size_t nextSize( uint32_t& rnd )
+	{
+		rnd = rnd * 1103515245 + 12345;
+		return 16 + ( ( rnd >> 16 ) & 0x1ff );
+	}
+
+	static void benchMallocRequests( size_t requestCnt )
+	{
+		std::vector<void*> ptrs( allocsPerRequest );
+		uint32_t rnd = 0;
+		uint64_t start = nowNs();
+		for ( size_t r=0; r<requestCnt; ++r )
+		{
+			for ( size_t i=0; i<allocsPerRequest; ++i )
+			{
+				ptrs[i] = malloc( nextSize( rnd ) );
+				*reinterpret_cast<uint8_t*>( ptrs[i] ) = (uint8_t)i;
+			}
+			for ( size_t i=0; i<allocsPerRequest; ++i )
+				free( ptrs[i] );
+		}
+		uint64_t end = nowNs();
+		report( "malloc/free per request", requestCnt * allocsPerRequest, end - start );
+	}
+
+	static void benchArenaRequests( size_t requestCnt )
+	{
+		ArenaAllocator arena;
+		uint32_t rnd = 0;
+		uint64_t start = nowNs();
+		for ( size_t r=0; r<requestCnt; ++r )
+		{
+			for ( size_t i=0; i<allocsPerRequest; ++i )
+				*reinterpret_cast<uint8_t*>( arena.allocate( nextSize( rnd ) ) ) = (uint8_t)i;
+			arena.reset();
+		}
+		uint64_t end = nowNs();
+		report( "ArenaAllocator::allocate, reset per request", requestCnt * allocsPerRequest, end - start );
+	}
+
+	void benchArenaAllocator()
+	{
+		benchMallocRequests( 1000 );
+		benchArenaRequests( 1000 );
+	}
+
+} // namespace nodecpp::bench
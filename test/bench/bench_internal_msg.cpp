@@ -0,0 +1,673 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+#include <foundation.h>
+#include <checksum.h>
+#include <internal_msg.h>
+#include <internal_msg_compress.h>
+#include <internal_msg_queue.h>
+#include <internal_msg_shm.h>
+#include <mapped_file.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#ifndef NODECPP_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/wait.h>
+#endif
+#include "bench.h"
+
+namespace nodecpp::bench {
+
+	using namespace nodecpp::platform::internal_msg;
+
+	static volatile uint64_t sink; // keeps reading from being optimized out
+
+	// build a message of a given size by appends of a typical field size, read it through, and destroy it
+	template<class PageProvider>
+	static void benchBuildAndFree( const char* providerName, size_t msgSize, size_t iterations )
+	{
+		uint8_t field[64];
+		for ( size_t i=0; i<sizeof(field); ++i )
+			field[i] = (uint8_t)i;
+		uint64_t checksum = 0;
+		uint64_t start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			InternalMsgImpl<PageProvider> msg;
+			for ( size_t done=0; done<msgSize; done += sizeof(field) )
+				msg.append( field, sizeof(field) );
+			auto it = msg.getReadIter();
+			size_t available = it.directlyAvailableSize();
+			while ( available )
+			{
+				checksum += *it.directRead( available );
+				available = it.directlyAvailableSize();
+			}
+		}
+		uint64_t end = nowNs();
+		sink = checksum;
+		char name[64];
+		snprintf( name, sizeof(name), "InternalMsg<%s>, %zdKb", providerName, msgSize / 1024 );
+		report( name, iterations * msgSize, end - start, "B" );
+	}
+
+	// a message passed on to the next stage: the whole of it is appended to a new one (shared by whole pages, if a provider allows)
+	template<class PageProvider>
+	static void benchForward( const char* providerName, size_t msgSize, size_t iterations )
+	{
+		using Msg = InternalMsgImpl<PageProvider>;
+		uint8_t field[64] = {};
+		Msg src;
+		for ( size_t done=0; done<msgSize; done += sizeof(field) )
+			src.append( field, sizeof(field) );
+		uint64_t start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			Msg dst;
+			dst.append( src.getReadIter(), src.size() );
+		}
+		uint64_t end = nowNs();
+		char name[64];
+		snprintf( name, sizeof(name), "InternalMsg<%s>, %zdKb, forwarded", providerName, msgSize / 1024 );
+		report( name, iterations * msgSize, end - start, "B" );
+	}
+
+	// a 1Mb message to each of 16 subscribers: copies vs. clones
+	static void benchFanOut( size_t msgSize, size_t subscriberCnt, size_t iterations )
+	{
+		InternalMsg src;
+		for ( size_t i=0; i<msgSize / sizeof( uint64_t ); ++i )
+			src.appendUint64( i );
+		std::vector<InternalMsg> subscribers( subscriberCnt );
+		uint64_t start = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+			for ( auto& msg : subscribers )
+			{
+				msg.clear();
+				auto it = src.getReadIter();
+				while ( it.isData() )
+				{
+					size_t sz = it.directlyAvailableSize();
+					msg.append( it.directRead( sz ), sz );
+				}
+			}
+		uint64_t mid = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+			for ( auto& msg : subscribers )
+				msg = src.clone();
+		uint64_t end = nowNs();
+		char name[64];
+		snprintf( name, sizeof( name ), "InternalMsg, %zdKb to %zd, copied", msgSize / 1024, subscriberCnt );
+		report( name, iterations * subscriberCnt * msgSize, mid - start, "B" );
+		snprintf( name, sizeof( name ), "InternalMsg, %zdKb to %zd, cloned", msgSize / 1024, subscriberCnt );
+		report( name, iterations * subscriberCnt * msgSize, end - mid, "B" );
+	}
+
+	// parsing records of { uint32_t, varint, uint16_t }: byte by byte vs. typed readers
+	static void benchParse( size_t recordCnt, size_t iterations )
+	{
+		InternalMsg msg;
+		for ( size_t i=0; i<recordCnt; ++i )
+		{
+			msg.appendUint32( (uint32_t)i );
+			msg.appendVarUint( i & 0xffff );
+			msg.appendUint16( (uint16_t)i );
+		}
+
+		uint64_t checksum = 0;
+		uint64_t start = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			auto it = msg.getReadIter();
+			for ( size_t i=0; i<recordCnt; ++i )
+			{
+				uint32_t u32 = 0;
+				for ( size_t j=0; j<4; ++j )
+					u32 |= (uint32_t)(uint8_t)it.readChar() << ( 8 * j );
+				uint64_t var = 0;
+				for ( size_t j=0; ; ++j )
+				{
+					uint8_t b = (uint8_t)it.readChar();
+					var |= (uint64_t)( b & 0x7f ) << ( 7 * j );
+					if ( ( b & 0x80 ) == 0 )
+						break;
+				}
+				uint16_t u16 = (uint8_t)it.readChar();
+				u16 |= (uint16_t)( (uint8_t)it.readChar() << 8 );
+				checksum += u32 + var + u16;
+			}
+		}
+		uint64_t end = nowNs();
+		report( "InternalMsg, parse by readChar()", iterations * recordCnt, end - start, "records" );
+
+		start = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			auto it = msg.getReadIter();
+			for ( size_t i=0; i<recordCnt; ++i )
+			{
+				uint32_t u32 = it.readUint32();
+				uint64_t var = it.readVarUint();
+				uint16_t u16 = it.readUint16();
+				checksum += u32 + var + u16;
+			}
+		}
+		end = nowNs();
+		sink = checksum;
+		report( "InternalMsg, parse by typed readers", iterations * recordCnt, end - start, "records" );
+	}
+
+	// reading a value at an arbitrary offset of a 16Mb message: skip() from the beginning vs. getReadIter( offset )
+	static void benchSeek( size_t iterations )
+	{
+		constexpr size_t msgSize = 0x1000000;
+		uint8_t field[64] = {};
+		InternalMsg msg;
+		for ( size_t done=0; done<msgSize; done += sizeof(field) )
+			msg.append( field, sizeof(field) );
+
+		uint64_t checksum = 0;
+		uint32_t rnd = 0;
+		uint64_t start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			rnd = rnd * 1103515245 + 12345;
+			auto it = msg.getReadIter();
+			it.skip( rnd % ( msgSize - 8 ) );
+			checksum += it.readUint64();
+		}
+		uint64_t end = nowNs();
+		report( "InternalMsg, 16Mb, skip() to a random offset", iterations, end - start );
+
+		start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			rnd = rnd * 1103515245 + 12345;
+			checksum += msg.getReadIter( rnd % ( msgSize - 8 ) ).readUint64();
+		}
+		end = nowNs();
+		sink = checksum;
+		report( "InternalMsg, 16Mb, getReadIter( random offset )", iterations, end - start );
+	}
+
+#ifndef NODECPP_WINDOWS
+	// a message written to a file descriptor: flattened to a buffer first vs. gathered right from its pages
+	static void benchWriteOut( size_t msgSize, size_t iterations )
+	{
+		int fd = open( "/dev/null", O_WRONLY );
+		uint8_t field[64] = {};
+		InternalMsg msg;
+		for ( size_t done=0; done<msgSize; done += sizeof(field) )
+			msg.append( field, sizeof(field) );
+
+		std::vector<uint8_t> flat( msgSize );
+		uint64_t start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			auto it = msg.getReadIter();
+			it.read( flat.data(), msg.size() );
+			for ( size_t done=0; done<msgSize; )
+				done += write( fd, flat.data() + done, msgSize - done );
+		}
+		uint64_t end = nowNs();
+		report( "InternalMsg, 1Mb, flattened + write()", iterations * msgSize, end - start, "B" );
+
+		IoVec vecs[64];
+		start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			auto it = msg.getReadIter();
+			while ( it.isData() )
+				it.skip( writev( fd, vecs, (int)it.gather( vecs, 64 ) ) );
+		}
+		end = nowNs();
+		report( "InternalMsg, 1Mb, gather + writev()", iterations * msgSize, end - start, "B" );
+		close( fd );
+	}
+#endif
+
+	// appending fields of 64 bytes, and reading them back by typed readers, for pages of a given size
+	template<size_t pageSize_>
+	static void benchPageSize( size_t msgSize, size_t iterations )
+	{
+		using Msg = InternalMsgImpl<MallocPageProviderT<pageSize_>>;
+		uint8_t field[64] = {};
+		uint64_t checksum = 0;
+		uint64_t appendNs = 0;
+		uint64_t readNs = 0;
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			Msg msg;
+			uint64_t start = nowNs();
+			for ( size_t done=0; done<msgSize; done += sizeof(field) )
+				msg.append( field, sizeof(field) );
+			uint64_t mid = nowNs();
+			auto it = msg.getReadIter();
+			for ( size_t i=0; i<msgSize / sizeof(uint64_t); ++i )
+				checksum += it.readUint64();
+			readNs += nowNs() - mid;
+			appendNs += mid - start;
+		}
+		sink = checksum;
+		char name[64];
+		snprintf( name, sizeof(name), "InternalMsg, %zdKb pages, append", pageSize_ / 1024 );
+		report( name, iterations * msgSize, appendNs, "B" );
+		snprintf( name, sizeof(name), "InternalMsg, %zdKb pages, readUint64()", pageSize_ / 1024 );
+		report( name, iterations * msgSize, readNs, "B" );
+	}
+
+	// small control messages (a header and a short string), a thousand of them alive at a time
+	struct PoolPageProviderWithoutCells : public PoolPageProvider
+	{
+		static constexpr size_t cellSize = 0;
+	};
+
+	template<class PageProvider>
+	static void benchSmall( const char* providerName, size_t iterations )
+	{
+		using Msg = InternalMsgImpl<PageProvider>;
+		constexpr size_t msgCnt = 1000;
+		static Msg msgs[msgCnt];
+		uint64_t checksum = 0;
+		uint64_t start = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			for ( size_t i=0; i<msgCnt; ++i )
+			{
+				msgs[i].appendUint32( (uint32_t)i );
+				msgs[i].appendVarUint( n );
+				msgs[i].appendLengthPrefixedString( "a short control message of some 60 bytes, more or less" );
+			}
+			for ( size_t i=0; i<msgCnt; ++i )
+			{
+				checksum += msgs[i].getReadIter().readUint32();
+				msgs[i].clear();
+			}
+		}
+		uint64_t end = nowNs();
+		sink = checksum;
+		char name[64];
+		snprintf( name, sizeof(name), "InternalMsg<%s>, small", providerName );
+		report( name, iterations * msgCnt, end - start, "msgs" );
+	}
+
+	// messages built on one thread and destroyed on another
+	template<class PageProvider>
+	static void benchCrossThread( const char* providerName, size_t msgSize, size_t iterations )
+	{
+		using Msg = InternalMsgImpl<PageProvider>;
+		constexpr size_t ringSize = 64;
+		std::atomic<Msg*> ring[ringSize];
+		for ( auto& slot : ring )
+			slot.store( nullptr, std::memory_order_relaxed );
+		uint8_t field[64] = {};
+		uint64_t start = nowNs();
+		std::thread consumer( [&]() {
+			for ( size_t i=0; i<iterations; ++i )
+			{
+				Msg* ptr;
+				while ( ( ptr = ring[i % ringSize].exchange( nullptr, std::memory_order_acquire ) ) == nullptr )
+					std::this_thread::yield();
+				Msg msg;
+				msg.restoreFromPointer( ptr );
+			}
+		} );
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			Msg msg;
+			for ( size_t done=0; done<msgSize; done += sizeof(field) )
+				msg.append( field, sizeof(field) );
+			while ( ring[i % ringSize].load( std::memory_order_relaxed ) != nullptr )
+				std::this_thread::yield();
+			ring[i % ringSize].store( msg.convertToPointer(), std::memory_order_release );
+		}
+		consumer.join();
+		uint64_t end = nowNs();
+		char name[64];
+		snprintf( name, sizeof(name), "InternalMsg<%s>, %zdKb, cross-thread", providerName, msgSize / 1024 );
+		report( name, iterations * msgSize, end - start, "B" );
+	}
+
+	// small messages passed from producers to a consumer through InternalMsgQueue
+	static void benchQueue( size_t producerCnt, size_t msgCnt )
+	{
+		InternalMsgQueue queue;
+		uint64_t start = nowNs();
+		std::vector<std::thread> producers;
+		for ( size_t p=0; p<producerCnt; ++p )
+			producers.emplace_back( [&queue, msgCnt]() {
+				for ( size_t i=0; i<msgCnt; ++i )
+				{
+					InternalMsg msg;
+					msg.appendUint64( i );
+					queue.push( msg );
+				}
+			} );
+		uint64_t checksum = 0;
+		InternalMsg batch[32];
+		for ( size_t received=0; received<producerCnt * msgCnt; )
+		{
+			size_t cnt = queue.popBatch( batch, std::size( batch ) );
+			if ( cnt == 0 )
+				std::this_thread::yield();
+			for ( size_t j=0; j<cnt; ++j )
+			{
+				checksum += batch[j].getReadIter().readUint64();
+				batch[j].clear();
+			}
+			received += cnt;
+		}
+		for ( auto& t : producers )
+			t.join();
+		uint64_t end = nowNs();
+		sink = checksum;
+		char name[64];
+		snprintf( name, sizeof(name), "InternalMsgQueue, %zd producer(s)", producerCnt );
+		report( name, producerCnt * msgCnt, end - start, "msgs" );
+	}
+
+#ifndef NODECPP_WINDOWS
+	// messages built by one process and consumed (and released) by another, through ShmPagePool
+	static void benchShm( size_t msgSize, size_t iterations )
+	{
+		int fd = ShmPagePool::create( 0x4000000 );
+		uint8_t field[64] = {};
+		uint64_t start = nowNs();
+		pid_t pid = fork();
+		if ( pid == 0 )
+		{
+			ShmMsgChannel in( 0 );
+			ShmInternalMsg msg;
+			for ( size_t i=0; i<iterations; )
+			{
+				if ( in.pop( msg ) )
+				{
+					msg.clear();
+					++i;
+				}
+				else
+					sched_yield();
+			}
+			_exit( 0 );
+		}
+		ShmMsgChannel out( 0 );
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			ShmInternalMsg msg;
+			for ( size_t done=0; done<msgSize; done += sizeof(field) )
+				msg.append( field, sizeof(field) );
+			while ( !out.push( msg ) )
+				sched_yield();
+		}
+		waitpid( pid, nullptr, 0 );
+		uint64_t end = nowNs();
+		ShmPagePool::detach();
+		close( fd );
+		char name[64];
+		snprintf( name, sizeof(name), "ShmInternalMsg, %zdKb, cross-process", msgSize / 1024 );
+		report( name, iterations * msgSize, end - start, "B" );
+	}
+
+	// parsing a file of uint64_t values: read into a message by readv() vs. mapped (the file is in the OS page cache in both cases)
+	static void benchFileIngest( size_t fileSize, size_t iterations )
+	{
+		char path[] = "/tmp/nodecpp_bench_XXXXXX";
+		int fd = mkstemp( path );
+		std::vector<uint64_t> data( fileSize / sizeof( uint64_t ) );
+		for ( size_t i=0; i<data.size(); ++i )
+			data[i] = i;
+		if ( write( fd, data.data(), fileSize ) != (ssize_t)fileSize )
+			return;
+
+		uint64_t checksum = 0;
+		uint64_t start = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			lseek( fd, 0, SEEK_SET );
+			InternalMsg msg;
+			IoVec vecs[16];
+			for (;;)
+			{
+				size_t cnt = msg.prepareReceive( vecs, std::size( vecs ) );
+				ssize_t rd = readv( fd, vecs, (int)cnt );
+				msg.commitReceive( vecs, cnt, rd > 0 ? rd : 0 );
+				if ( rd <= 0 )
+					break;
+			}
+			auto it = msg.getReadIter();
+			while ( it.isData() )
+				checksum += it.readUint64();
+		}
+		uint64_t mid = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			MappedFile file( path );
+			auto it = file.getReadIter();
+			while ( it.isData() )
+				checksum += it.readUint64();
+		}
+		uint64_t end = nowNs();
+		sink = checksum;
+		close( fd );
+		unlink( path );
+		report( "InternalMsg, 64Mb file, readv() + parse", iterations * fileSize, mid - start, "B" );
+		report( "MappedFile, 64Mb file, parse", iterations * fileSize, end - mid, "B" );
+	}
+#endif
+
+	// checksumming a 64Mb message page by page, against just reading it
+	static void benchChecksum( size_t msgSize, size_t iterations )
+	{
+		InternalMsg msg;
+		for ( size_t i=0; i<msgSize / sizeof( uint64_t ); ++i )
+			msg.appendUint64( i * 0x9e3779b97f4a7c15ull );
+
+		uint64_t checksum = 0;
+		uint64_t t0 = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			auto it = msg.getReadIter();
+			nodecpp::impl::forEachBlock( it, msgSize, [&checksum]( const uint8_t* data, size_t sz ) {
+				for ( size_t i=0; i+8<=sz; i+=8 )
+				{
+					uint64_t v;
+					memcpy( &v, data + i, sizeof( v ) );
+					checksum += v;
+				}
+			} );
+		}
+		uint64_t t1 = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			nodecpp::Crc32c crc;
+			crc.update( msg.getReadIter(), msgSize );
+			checksum += crc.value();
+		}
+		uint64_t t2 = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			auto it = msg.getReadIter();
+			uint32_t crc = 0;
+			nodecpp::impl::forEachBlock( it, msgSize, [&crc]( const uint8_t* data, size_t sz ) { crc = nodecpp::crc32cSoftware( data, sz, crc ); } );
+			checksum += crc;
+		}
+		uint64_t t3 = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			nodecpp::XXH64 h;
+			h.update( msg.getReadIter(), msgSize );
+			checksum += h.digest();
+		}
+		uint64_t t4 = nowNs();
+		sink = checksum;
+		char name[64];
+		report( "InternalMsg, 64Mb, sum of uint64", iterations * msgSize, t1 - t0, "B" );
+		snprintf( name, sizeof( name ), "InternalMsg, 64Mb, crc32c (%s)", nodecpp::crc32cImplementation() );
+		report( name, iterations * msgSize, t2 - t1, "B" );
+		report( "InternalMsg, 64Mb, crc32c (slicing-by-8)", iterations * msgSize, t3 - t2, "B" );
+		report( "InternalMsg, 64Mb, xxh64", iterations * msgSize, t4 - t3, "B" );
+	}
+
+	// compressing a log-like 16Mb message and back
+	static void benchCompress( size_t msgSize, CompressionMethod method, int level, size_t blockSize, size_t iterations )
+	{
+		InternalMsg msg;
+		for ( size_t i=0; msg.size()<msgSize; ++i )
+		{
+			msg.appendLengthPrefixedString( std::string_view( "[info] request completed, status ok", 12 + i % 24 ) );
+			msg.appendUint32( (uint32_t)( i * 7 ) );
+		}
+		CompressionOptions options;
+		options.method = method;
+		options.level = level;
+		options.blockSize = blockSize;
+		size_t compressedSz = 0;
+		uint64_t start = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			InternalMsg compressed;
+			compress( msg.getReadIter(), msg.size(), compressed, options );
+			compressedSz = compressed.size();
+		}
+		uint64_t mid = nowNs();
+		InternalMsg compressed;
+		compress( msg.getReadIter(), msg.size(), compressed, options );
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			InternalMsg restored;
+			decompress( compressed.getReadIter(), compressed.size(), restored, method );
+			sink = restored.size();
+		}
+		uint64_t end = nowNs();
+		const char* methodName = method == CompressionMethod::lz4 ? "lz4" : "zstd";
+		char name[96];
+		snprintf( name, sizeof( name ), "%s, level %d, %zuKb blocks, %.1f%%, compress", methodName, level, blockSize >> 10, compressedSz * 100.0 / msg.size() );
+		report( name, iterations * msg.size(), mid - start, "B" );
+		snprintf( name, sizeof( name ), "%s, level %d, %zuKb blocks, decompress", methodName, level, blockSize >> 10 );
+		report( name, iterations * msg.size(), end - mid, "B" );
+	}
+
+	// filling a 1Mb message by small pieces: appends vs. InternalMsg::Writer
+	static void benchAppendBytes( size_t msgSize, size_t iterations )
+	{
+		uint64_t start = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			InternalMsg msg;
+			for ( size_t i=0; i<msgSize; ++i )
+				msg.appendUint8( (uint8_t)i );
+		}
+		uint64_t mid = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			InternalMsg msg;
+			InternalMsg::Writer w( msg );
+			for ( size_t i=0; i<msgSize; ++i )
+				w.writeUint8( (uint8_t)i );
+		}
+		uint64_t end = nowNs();
+		report( "InternalMsg, appendUint8()", iterations * msgSize, mid - start, "B" );
+		report( "InternalMsg::Writer, writeUint8()", iterations * msgSize, end - mid, "B" );
+	}
+
+	static void benchAppendUint32( size_t msgSize, size_t iterations )
+	{
+		size_t cnt = msgSize / sizeof( uint32_t );
+		uint64_t start = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			InternalMsg msg;
+			for ( size_t i=0; i<cnt; ++i )
+				msg.appendUint32( (uint32_t)i );
+		}
+		uint64_t mid = nowNs();
+		for ( size_t n=0; n<iterations; ++n )
+		{
+			InternalMsg msg;
+			InternalMsg::Writer w( msg );
+			for ( size_t i=0; i<cnt; ++i )
+				w.writeLE<uint32_t>( (uint32_t)i );
+		}
+		uint64_t end = nowNs();
+		report( "InternalMsg, appendUint32()", iterations * msgSize, mid - start, "B" );
+		report( "InternalMsg::Writer, writeLE<uint32_t>()", iterations * msgSize, end - mid, "B" );
+	}
+
+	void benchInternalMsgAppend()
+	{
+		benchAppendBytes( 0x100000, 200 );
+		benchAppendUint32( 0x100000, 200 );
+	}
+
+	void benchInternalMsg()
+	{
+		benchBuildAndFree<MallocPageProvider>( "malloc", 0x400, 200000 );
+		benchBuildAndFree<PoolPageProvider>( "pool", 0x400, 200000 );
+		benchBuildAndFree<MallocPageProvider>( "malloc", 0x10000, 20000 );
+		benchBuildAndFree<PoolPageProvider>( "pool", 0x10000, 20000 );
+		benchBuildAndFree<MallocPageProvider>( "malloc", 0x5000, 100000 );
+		benchBuildAndFree<PoolPageProvider>( "pool", 0x5000, 100000 );
+		benchBuildAndFree<MallocPageProvider>( "malloc", 0x1000000, 20 );
+		benchBuildAndFree<PoolPageProvider>( "pool", 0x1000000, 20 );
+		benchForward<MallocPageProvider>( "malloc", 0x100000, 2000 );
+		benchForward<PoolPageProvider>( "pool", 0x100000, 2000 );
+		benchFanOut( 0x100000, 16, 200 );
+		benchParse( 100000, 100 );
+		benchSeek( 20000 );
+#ifndef NODECPP_WINDOWS
+		benchWriteOut( 0x100000, 2000 );
+#endif
+		benchPageSize<0x400>( 0x1000000, 10 );
+		benchPageSize<0x1000>( 0x1000000, 10 );
+		benchPageSize<0x10000>( 0x1000000, 10 );
+		benchPageSize<0x200000>( 0x1000000, 10 );
+		benchSmall<MallocPageProvider>( "malloc", 2000 );
+		benchSmall<PoolPageProviderWithoutCells>( "pool, no cells", 2000 );
+		benchSmall<PoolPageProvider>( "pool", 2000 );
+		benchCrossThread<MallocPageProvider>( "malloc", 0x10000, 20000 );
+		benchCrossThread<PoolPageProvider>( "pool", 0x10000, 20000 );
+		benchQueue( 1, 1000000 );
+		benchQueue( 4, 250000 );
+#ifndef NODECPP_WINDOWS
+		benchShm( 0x10000, 20000 );
+		benchShm( 0x400, 200000 );
+		benchFileIngest( 0x4000000, 10 );
+#endif
+		benchChecksum( 0x4000000, 10 );
+		benchCompress( 0x1000000, CompressionMethod::lz4, 0, 0x10000, 10 );
+		benchCompress( 0x1000000, CompressionMethod::lz4, -8, 0x10000, 10 );
+		benchCompress( 0x1000000, CompressionMethod::lz4, 9, 0x400000, 10 );
+		benchCompress( 0x1000000, CompressionMethod::zstd, 1, 0x10000, 10 );
+		benchCompress( 0x1000000, CompressionMethod::zstd, 3, 0x400000, 10 );
+		benchCompress( 0x1000000, CompressionMethod::zstd, 9, 0x400000, 10 );
+	}
+
+} // namespace nodecpp::bench
@@ -0,0 +1,162 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include <foundation.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "bench.h"
+
+namespace nodecpp::bench {
+
+	// A producer and a writer thread hammering the same LogBufferBaseData (same pattern as in test/main.cpp)
+	static void benchLogProducers( size_t producerCnt, size_t msgPerProducer )
+	{
+		FILE* devnull = fopen( "/dev/null", "wb" );
+		if ( devnull == nullptr )
+			return;
+		uint64_t start;
+		uint64_t end;
+		{
+			nodecpp::log::Log log;
+			log.level = nodecpp::log::LogLevel::info;
+			log.addTimeStamp = false;
+			log.add( devnull );
+
+			std::vector<std::thread> producers;
+			start = nowNs();
+			for ( size_t t=0; t<producerCnt; ++t )
+				producers.emplace_back( [&log, msgPerProducer, t]() {
+					for ( size_t i=0; i<msgPerProducer; ++i )
+						log.warning( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "producer {} message # {}", t, i );
+				} );
+			for ( auto& p : producers )
+				p.join();
+			end = nowNs();
+			log.setTerminationAllowed();
+		}
+		char name[64];
+		snprintf( name, sizeof(name), "log: %zd producer(s) vs. writer", producerCnt );
+		report( name, producerCnt * msgPerProducer, end - start, "msg" );
+	}
+
+	static volatile uint64_t sink; // keeps reading from being optimized out
+
+	// LogBufferBaseData as it was before its fields were grouped by cache lines (same fields, same order), to compare layouts
+	struct UngroupedLogBufferData
+	{
+		nodecpp::log::LogLevel levelCouldBeSkipped = nodecpp::log::LogLevel::info;
+		nodecpp::log::LogLevel levelGuaranteedWrite = nodecpp::log::LogLevel::fatal;
+		size_t pageSize = 0;
+		uint8_t* buff = nullptr;
+		size_t buffSize = 0;
+		uint64_t start = 0;
+		uint64_t writerPromisedNextStart = 0;
+		uint64_t end = 0;
+		uint64_t mustBeWrittenImmediately = 0;
+		nodecpp::log::SkippedMsgCounters skippedCtrs;
+		std::condition_variable waitWriter;
+		size_t refCounter = 0;
+		std::mutex mx;
+		void* firstToRelease = nullptr;
+		void* nextToAdd = nullptr;
+		void* firstToReleaseGuaranteed = nullptr;
+		void* nextToAddGuaranteed = nullptr;
+		int action = 0;
+		FILE* target = nullptr;
+	};
+
+	// The layout alone, with no LogTransport around: producers move 'end' under the mutex, as LogTransport::addMsg() does, 
+	// while a writer keeps reading buff/buffSize/target without locking and takes the mutex now and then to move 'start', 
+	// as the writing thread does. Unlike benchLogProducers(), it runs with several producers; it shows anything on several cores only
+	template<class DataT>
+	static void benchLogLayout( const char* layoutName, size_t producerCnt, size_t opsPerProducer )
+	{
+		DataT data;
+		uint8_t buff[0x100];
+		data.buff = buff;
+		data.buffSize = sizeof( buff );
+		data.target = stdout;
+		std::atomic<bool> done = false;
+		uint64_t writerReads = 0;
+		std::thread writer( [&data, &done, &writerReads]() {
+			uint64_t sum = 0;
+			uint64_t reads = 0;
+			while ( !done.load( std::memory_order_relaxed ) )
+			{
+				for ( size_t i=0; i<64; ++i )
+				{
+					std::atomic_signal_fence( std::memory_order_seq_cst ); // reads are not to be hoisted out of the loop
+					sum += (uintptr_t)data.buff + data.buffSize + (uintptr_t)data.target;
+				}
+				reads += 64;
+				std::unique_lock<std::mutex> lock( data.mx );
+				data.start = data.end;
+			}
+			sink = sum;
+			writerReads = reads;
+		} );
+
+		std::vector<std::thread> producers;
+		uint64_t start = nowNs();
+		for ( size_t t=0; t<producerCnt; ++t )
+			producers.emplace_back( [&data, opsPerProducer]() {
+				for ( size_t i=0; i<opsPerProducer; ++i )
+				{
+					std::unique_lock<std::mutex> lock( data.mx );
+					data.end += 64;
+					++data.mustBeWrittenImmediately;
+				}
+			} );
+		for ( auto& p : producers )
+			p.join();
+		uint64_t end = nowNs();
+		done = true;
+		writer.join();
+
+		char name[96];
+		snprintf( name, sizeof(name), "log layout, %s: %zd producer(s)", layoutName, producerCnt );
+		report( name, producerCnt * opsPerProducer, end - start, "op" );
+		snprintf( name, sizeof(name), "log layout, %s: writer reads", layoutName );
+		report( name, writerReads, end - start, "read" );
+	}
+
+	void benchLog()
+	{
+		// NOTE: so far a single producer only; with more of them LogTransport::addMsg() hits its own assertions on waiting list handling
+		benchLogProducers( 1, 200000 );
+		benchLogProducers( 1, 1000000 );
+		for ( size_t producerCnt : { 1, 2, 4 } )
+		{
+			benchLogLayout<UngroupedLogBufferData>( "ungrouped", producerCnt, 2000000 / producerCnt );
+			benchLogLayout<nodecpp::log::LogBufferBaseData>( "grouped", producerCnt, 2000000 / producerCnt );
+		}
+	}
+
+} // namespace nodecpp::bench
@@ -0,0 +1,164 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include <foundation.h>
+#include <page_allocator.h>
+#include <page_cache.h>
+#include <vector>
+#include "bench.h"
+
+namespace nodecpp::bench {
+
+	// commit a chunk of a reserved range, touch its pages, decommit it; a typical arena/stack recycling pattern
+	static void benchCommitDecommit( size_t chunkPages, size_t iterations )
+	{
+		size_t pageSize = VirtualMemory::getPageSize();
+		size_t chunkSize = chunkPages * pageSize;
+		constexpr size_t chunkCnt = 64;
+		uint8_t* base = reinterpret_cast<uint8_t*>( VirtualMemory::AllocateAddressSpace( chunkSize * chunkCnt ) );
+		uint64_t start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			uint8_t* chunk = base + ( i % chunkCnt ) * chunkSize;
+			VirtualMemory::CommitMemory( chunk, chunkSize );
+			for ( size_t j=0; j<chunkSize; j+=pageSize )
+				chunk[j] = (uint8_t)i;
+			VirtualMemory::DecommitMemory( chunk, chunkSize );
+		}
+		uint64_t end = nowNs();
+		VirtualMemory::FreeAddressSpace( base, chunkSize * chunkCnt );
+		char name[64];
+		snprintf( name, sizeof(name), "commit/touch/decommit, %zd page(s)", chunkPages );
+		report( name, iterations, end - start, "cycles" );
+	}
+
+	static void benchAllocateDeallocate( size_t pageCnt, size_t iterations )
+	{
+		size_t size = pageCnt * VirtualMemory::getPageSize();
+		uint64_t start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			uint8_t* p = reinterpret_cast<uint8_t*>( VirtualMemory::allocate( size ) );
+			p[0] = (uint8_t)i;
+			VirtualMemory::deallocate( p, size );
+		}
+		uint64_t end = nowNs();
+		char name[64];
+		snprintf( name, sizeof(name), "VirtualMemory::allocate/deallocate, %zd page(s)", pageCnt );
+		report( name, iterations, end - start );
+	}
+
+	static void benchPageCache( size_t pageCnt, size_t iterations )
+	{
+		uint64_t start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			uint8_t* p = reinterpret_cast<uint8_t*>( PageCache::acquire( pageCnt ) );
+			p[0] = (uint8_t)i;
+			PageCache::release( p, pageCnt );
+		}
+		uint64_t end = nowNs();
+		char name[64];
+		snprintf( name, sizeof(name), "PageCache::acquire/release, %zd page(s)", pageCnt );
+		report( name, iterations, end - start );
+	}
+
+	// pages for a multi-megabyte message: one by one vs. a single batch
+	static void benchManyPages( size_t pageCnt, size_t iterations )
+	{
+		std::vector<void*> pages( pageCnt );
+		uint64_t start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			for ( size_t j=0; j<pageCnt; ++j )
+				pages[j] = VirtualMemory::allocate( VirtualMemory::getPageSize() );
+			for ( size_t j=0; j<pageCnt; ++j )
+				*reinterpret_cast<uint8_t*>( pages[j] ) = (uint8_t)j;
+			for ( size_t j=0; j<pageCnt; ++j )
+				VirtualMemory::deallocate( pages[j], VirtualMemory::getPageSize() );
+		}
+		uint64_t end = nowNs();
+		char name[64];
+		snprintf( name, sizeof(name), "%zd x VirtualMemory::allocate/deallocate", pageCnt );
+		report( name, iterations * pageCnt, end - start, "pages" );
+
+		start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			VirtualMemory::allocateMany( pages.data(), pageCnt, VirtualMemory::getPageSize() );
+			for ( size_t j=0; j<pageCnt; ++j )
+				*reinterpret_cast<uint8_t*>( pages[j] ) = (uint8_t)j;
+			VirtualMemory::deallocateMany( pages.data(), pageCnt, VirtualMemory::getPageSize() );
+		}
+		end = nowNs();
+		snprintf( name, sizeof(name), "VirtualMemory::allocateMany/deallocateMany(%zd)", pageCnt );
+		report( name, iterations * pageCnt, end - start, "pages" );
+
+		start = nowNs();
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			PageCache::acquireMany( pages.data(), pageCnt, 1 );
+			for ( size_t j=0; j<pageCnt; ++j )
+				*reinterpret_cast<uint8_t*>( pages[j] ) = (uint8_t)j;
+			PageCache::releaseMany( pages.data(), pageCnt, 1 );
+		}
+		end = nowNs();
+		snprintf( name, sizeof(name), "PageCache::acquireMany/releaseMany(%zd)", pageCnt );
+		report( name, iterations * pageCnt, end - start, "pages" );
+	}
+
+	// what the hot path pays on first touches of a fresh range, with and without prefaulting it in advance
+	static void benchFirstTouch( uint32_t flags, const char* name, size_t pageCnt, size_t iterations )
+	{
+		size_t pageSize = VirtualMemory::getPageSize();
+		uint64_t total = 0;
+		for ( size_t i=0; i<iterations; ++i )
+		{
+			uint8_t* p = reinterpret_cast<uint8_t*>( VirtualMemory::allocate( pageCnt * pageSize, flags ) );
+			uint64_t start = nowNs();
+			for ( size_t j=0; j<pageCnt; ++j )
+				p[j * pageSize] = (uint8_t)j;
+			total += nowNs() - start;
+			VirtualMemory::deallocate( p, pageCnt * pageSize );
+		}
+		report( name, iterations * pageCnt, total, "pages" );
+	}
+
+	void benchPageAllocator()
+	{
+		benchCommitDecommit( 1, 200000 );
+		benchCommitDecommit( 16, 50000 );
+		benchAllocateDeallocate( 1, 200000 );
+		benchPageCache( 1, 200000 );
+		benchAllocateDeallocate( 16, 100000 );
+		benchPageCache( 16, 100000 );
+		benchManyPages( 512, 200 );
+		benchFirstTouch( VirtualMemory::noFlags, "first touch, as allocated", 256, 200 );
+		benchFirstTouch( VirtualMemory::prefault, "first touch, prefaulted", 256, 200 );
+	}
+
+} // namespace nodecpp::bench
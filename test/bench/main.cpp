@@ -0,0 +1,64 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+// Microbenchmarks for foundation primitives. Not a part of the test suite;
+// usage: bench_foundation [name]; runs all benchmarks if no name is given
+
+#include <string.h>
+#include <foundation.h>
+#include "bench.h"
+
+struct BenchEntry
+{
+	const char* name;
+	void (*fn)();
+};
+
+static const BenchEntry benchmarks[] = {
+	{ "log", nodecpp::bench::benchLog },
+	{ "page_allocator", nodecpp::bench::benchPageAllocator },
+	{ "arena_allocator", nodecpp::bench::benchArenaAllocator },
+	{ "internal_msg", nodecpp::bench::benchInternalMsg },
+	{ "internal_msg_append", nodecpp::bench::benchInternalMsgAppend },
+};
+
+int main(int argc, char *argv[])
+{
+	nodecpp::log::Log log;
+	log.level = nodecpp::log::LogLevel::warning;
+	log.add( stderr );
+	nodecpp::logging_impl::currentLog = &log;
+
+	const char* which = argc > 1 ? argv[1] : nullptr;
+	for ( auto& b : benchmarks )
+		if ( which == nullptr || strcmp( which, b.name ) == 0 )
+		{
+			printf( "--- %s ---\n", b.name );
+			b.fn();
+		}
+	return 0;
+}
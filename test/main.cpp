@@ -346,6 +346,925 @@ void testVectorOfPages()
 	}
 }
 
+template<class MsgT>
+static void fillMsg( MsgT& msg, size_t sz, uint8_t seed )
+{
+	uint8_t buff[1000];
+	for ( size_t done=0; done<sz; )
+	{
+		size_t chunk = sz - done < sizeof( buff ) ? sz - done : sizeof( buff );
+		for ( size_t i=0; i<chunk; ++i )
+			buff[i] = (uint8_t)( ( done + i ) * 7 + seed );
+		msg.append( buff, chunk );
+		done += chunk;
+	}
+}
+
+template<class MsgT>
+static void checkMsg( const MsgT& msg, size_t offset, size_t sz, uint8_t seed )
+{
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, msg.size() >= offset + sz, "{} vs. {}", msg.size(), offset + sz );
+	auto it = msg.getReadIter();
+	it.skip( offset );
+	for ( size_t i=0; i<sz; ++i )
+	{
+		uint8_t ch = (uint8_t)it.readChar();
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, ch == (uint8_t)( i * 7 + seed ), "at {}", i );
+	}
+}
+
+template<class MsgT>
+static size_t countSharedPages( const MsgT& msg )
+{
+	size_t ret = 0;
+	auto it = msg.getReadIter();
+	while ( it.directlyAvailableSize() )
+	{
+		const uint8_t* ptr = it.directRead( it.directlyAvailableSize() );
+		if ( ( reinterpret_cast<uintptr_t>( ptr ) & ( nodecpp::PagePool::pageSize - 1 ) ) == 0 && nodecpp::PagePool::isShared( ptr ) )
+			++ret;
+	}
+	return ret;
+}
+
+void testInternalMsgSplice()
+{
+	using namespace nodecpp::platform::internal_msg;
+	constexpr size_t sz = 0x100000 + 123;
+	constexpr size_t wholePages = ( sz - ( pageSize - InternalMsg::total_reserved ) ) / pageSize;
+
+	// whole message to an empty one: everything but the first and the last page is shared
+	InternalMsg src;
+	fillMsg( src, sz, 1 );
+	InternalMsg dst;
+	dst.append( src.getReadIter(), src.size() );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, dst.size() == sz );
+	checkMsg( dst, 0, sz, 1 );
+	size_t shared = countSharedPages( dst );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, shared == wholePages, "{} vs. {}", shared, wholePages );
+
+	// pages survive their other holder
+	src.clear();
+	checkMsg( dst, 0, sz, 1 );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, countSharedPages( dst ) == 0 );
+
+	// appending to a shared message does not modify shared pages
+	InternalMsg dst2;
+	dst2.append( dst.getReadIter(), dst.size() );
+	dst2.append( "abc", 3 );
+	dst.append( "def", 3 );
+	checkMsg( dst, 0, sz, 1 );
+	checkMsg( dst2, 0, sz, 1 );
+
+	// not at page boundaries: copied, and correct all the same
+	InternalMsg dst3;
+	fillMsg( dst3, 5, 2 );
+	auto it = dst2.getReadIter();
+	it.skip( 100 );
+	dst3.append( it, sz - 100 );
+	checkMsg( dst3, 0, 5, 2 );
+	checkMsg( dst3, 5, sz - 100, (uint8_t)( 100 * 7 + 1 ) );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, countSharedPages( dst3 ) == 0 );
+
+	// a provider that cannot share pages copies them
+	InternalMsgImpl<MallocPageProvider> msrc;
+	fillMsg( msrc, sz, 3 );
+	InternalMsgImpl<MallocPageProvider> mdst;
+	mdst.append( msrc.getReadIter(), msrc.size() );
+	msrc.clear();
+	checkMsg( mdst, 0, sz, 3 );
+}
+
+void testInternalMsgTypedAccess()
+{
+	using namespace nodecpp::platform::internal_msg;
+	const uint64_t varUints[] = { 0, 1, 0x7f, 0x80, 0x3fff, 0x4000, 0xffffffff, 0x8000000000000000ull, 0xffffffffffffffffull };
+	const int64_t varInts[] = { 0, 1, -1, 63, -64, 64, -65, INT64_MAX, INT64_MIN };
+	std::string longStr( 5000, 'q' );
+	constexpr size_t recordCnt = 3000; // enough for values of all kinds to cross page boundaries at various offsets
+
+	InternalMsg msg;
+	for ( size_t i=0; i<recordCnt; ++i )
+	{
+		msg.appendUint8( (uint8_t)i );
+		msg.appendUint16( (uint16_t)( i * 3 ) );
+		msg.appendUint32( (uint32_t)( i * 0x10001 ) );
+		msg.appendUint64( i * 0x100000001ull );
+		msg.appendVarUint( varUints[i % std::size( varUints )] );
+		msg.appendVarInt( varInts[i % std::size( varInts )] );
+		msg.appendLengthPrefixedString( i % 100 == 0 ? std::string_view( longStr ) : std::string_view( "abcdefg", i % 8 ) );
+	}
+
+	// in the message, values are little-endian
+	{
+		auto it = msg.getReadIter();
+		uint8_t bytes[8];
+		it.skip( 1 + 2 );
+		it.read( bytes, 4 );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, bytes[0] == 0 && bytes[1] == 0 && bytes[2] == 0 && bytes[3] == 0 );
+	}
+
+	auto it = msg.getReadIter();
+	std::string buff;
+	for ( size_t i=0; i<recordCnt; ++i )
+	{
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.readUint8() == (uint8_t)i, "at {}", i );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.readUint16() == (uint16_t)( i * 3 ), "at {}", i );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.readUint32() == (uint32_t)( i * 0x10001 ), "at {}", i );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.readUint64() == i * 0x100000001ull, "at {}", i );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.readVarUint() == varUints[i % std::size( varUints )], "at {}", i );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.readVarInt() == varInts[i % std::size( varInts )], "at {}", i );
+		std::string_view str = it.readLengthPrefixedString( buff );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, i % 100 == 0 ? str == longStr : str == std::string_view( "abcdefg", i % 8 ), "at {}", i );
+	}
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, !it.isData() && it.offset() == msg.size(), "{} vs. {}", it.offset(), msg.size() );
+}
+
+void testInternalMsgRandomAccess()
+{
+	using namespace nodecpp::platform::internal_msg;
+	constexpr size_t sz = 0x600000 + 77; // more than one index page
+	InternalMsg msg;
+	fillMsg( msg, sz, 9 );
+
+	const size_t firstPageData = pageSize - InternalMsg::total_reserved;
+	const size_t offsets[] = { 0, 1, firstPageData - 1, firstPageData, firstPageData + 1, firstPageData + 3 * pageSize, 
+		firstPageData + 4 * pageSize - 1, firstPageData + 4 * pageSize + 5, 0x300000, 0x300000 + pageSize - 1, sz - pageSize, sz - 1, sz };
+	for ( size_t offset : offsets )
+	{
+		auto it = msg.getReadIter( offset );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.offset() == offset && it.totalAvailableSize() == sz - offset, "at {}", offset );
+		size_t toCheck = sz - offset < 2 * pageSize ? sz - offset : 2 * pageSize;
+		for ( size_t i=0; i<toCheck; ++i )
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, (uint8_t)it.readChar() == (uint8_t)( ( offset + i ) * 7 + 9 ), "at {} + {}", offset, i );
+		auto it2 = msg.getReadIter();
+		it2.skip( offset );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it2.offset() == offset && it2.totalAvailableSize() == sz - offset );
+	}
+
+	// patching: a length field in a header, values across page boundaries, and shared pages
+	InternalMsg framed;
+	framed.appendUint32( 0 );
+	fillMsg( framed, 0x10000, 4 );
+	framed.patchLE<uint32_t>( 0, (uint32_t)( framed.size() - 4 ) );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, framed.getReadIter().readUint32() == 0x10000 );
+
+	InternalMsg copy;
+	copy.append( msg.getReadIter(), msg.size() );
+	size_t boundary = firstPageData + 10 * pageSize;
+	uint64_t val = 0x0102030405060708ull;
+	copy.patchLE( boundary - 3, val );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, copy.getReadIter( boundary - 3 ).readUint64() == val );
+	checkMsg( msg, 0, sz, 9 );
+	checkMsg( copy, 0, boundary - 3, 9 );
+	auto it = copy.getReadIter( boundary + 5 );
+	for ( size_t i=0; i<pageSize; ++i )
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, (uint8_t)it.readChar() == (uint8_t)( ( boundary + 5 + i ) * 7 + 9 ), "at {}", i );
+}
+
+void testInternalMsgWriter()
+{
+	using namespace nodecpp::platform::internal_msg;
+	uint8_t blob[3000];
+	for ( size_t i=0; i<sizeof( blob ); ++i )
+		blob[i] = (uint8_t)( i * 13 );
+
+	// the same data written by a writer and by appends, starting both from an empty message and from a small one
+	for ( size_t prefix : { (size_t)0, (size_t)10 } )
+	{
+		InternalMsg expected;
+		InternalMsg msg;
+		fillMsg( expected, prefix, 1 );
+		fillMsg( msg, prefix, 1 );
+		{
+			InternalMsg::Writer w( msg );
+			for ( size_t i=0; i<20000; ++i )
+			{
+				expected.appendUint8( (uint8_t)i );
+				w.writeUint8( (uint8_t)i );
+				expected.appendUint32( (uint32_t)( i * 0x10001 ) );
+				w.writeLE<uint32_t>( (uint32_t)( i * 0x10001 ) );
+				expected.appendVarUint( i * i * i );
+				w.writeVarUint( i * i * i );
+				if ( i % 500 == 0 )
+				{
+					expected.append( blob, i % sizeof( blob ) );
+					w.write( blob, i % sizeof( blob ) );
+				}
+				if ( i == 10000 )
+				{
+					w.flush();
+					NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, msg.size() == expected.size(), "{} vs. {}", msg.size(), expected.size() );
+				}
+			}
+		}
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, msg.size() == expected.size(), "{} vs. {}", msg.size(), expected.size() );
+		auto it1 = msg.getReadIter();
+		auto it2 = expected.getReadIter();
+		for ( size_t i=0; i<expected.size(); ++i )
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it1.readChar() == it2.readChar(), "at {}", i );
+
+		// and the message goes on as usual
+		msg.append( blob, 10 );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, msg.size() == expected.size() + 10 );
+	}
+}
+
+#include <checksum.h>
+void testChecksums()
+{
+	using namespace nodecpp::platform::internal_msg;
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, nodecpp::crc32c( "123456789", 9 ) == 0xe3069283 );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, nodecpp::crc32cSoftware( "123456789", 9 ) == 0xe3069283 );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, nodecpp::XXH64::hash( "", 0 ) == 0xef46db3751d8e999ull );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, nodecpp::XXH64::hash( "abc", 3 ) == 0x44bc2cf5ad770999ull );
+
+	// whatever implementation is selected, it is the same function, at any length and alignment, and in pieces
+	uint8_t blob[3000];
+	for ( size_t i=0; i<sizeof( blob ); ++i )
+		blob[i] = (uint8_t)( i * 13 + ( i >> 8 ) );
+	for ( size_t i=0; i<300; ++i )
+	{
+		size_t start = ( i * 7 ) % 16;
+		size_t sz = ( i * i * 31 ) % ( sizeof( blob ) - start );
+		uint32_t crc = nodecpp::crc32c( blob + start, sz );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, crc == nodecpp::crc32cSoftware( blob + start, sz ), "{} at {}", sz, start );
+		size_t half = sz / 3;
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, crc == nodecpp::crc32c( blob + start + half, sz - half, nodecpp::crc32c( blob + start, half ) ), "{} at {}", sz, start );
+		nodecpp::XXH64 h( i );
+		h.update( blob + start, half );
+		h.update( blob + start + half, sz - half );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, h.digest() == nodecpp::XXH64::hash( blob + start, sz, i ), "{} at {}", sz, start );
+	}
+
+	// over a message, page by page, and as it grows
+	InternalMsg msg;
+	nodecpp::Crc32c crcOnAppend;
+	nodecpp::XXH64 xxhOnAppend;
+	for ( size_t i=0; i<200; ++i )
+	{
+		size_t sz = ( i * 101 ) % sizeof( blob );
+		msg.append( blob, sz );
+		crcOnAppend.update( blob, sz );
+		xxhOnAppend.update( blob, sz );
+	}
+	std::vector<uint8_t> flat( msg.size() );
+	msg.getReadIter().read( flat.data(), flat.size() );
+	nodecpp::Crc32c crc;
+	crc.update( msg.getReadIter(), msg.size() );
+	nodecpp::XXH64 xxh;
+	xxh.update( msg.getReadIter(), msg.size() );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, crc.value() == nodecpp::crc32c( flat.data(), flat.size() ) && crc.value() == crcOnAppend.value() );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, xxh.digest() == nodecpp::XXH64::hash( flat.data(), flat.size() ) && xxh.digest() == xxhOnAppend.digest() );
+
+	// a range of it
+	nodecpp::Crc32c part;
+	part.update( msg.getReadIter( 5000 ), 100000 );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, part.value() == nodecpp::crc32c( flat.data() + 5000, 100000 ) );
+}
+
+#include <internal_msg_compress.h>
+static bool decompressFails( const nodecpp::platform::internal_msg::InternalMsg& compressed, size_t sz, nodecpp::platform::internal_msg::CompressionMethod method )
+{
+	nodecpp::platform::internal_msg::InternalMsg restored;
+	try { nodecpp::platform::internal_msg::decompress( compressed.getReadIter(), sz, restored, method ); }
+	catch ( nodecpp::error::error e ) { return e == nodecpp::error::bad_message; }
+	return false;
+}
+
+void testInternalMsgCompress()
+{
+	using namespace nodecpp::platform::internal_msg;
+
+	// text-like, repetitive, and random data, of many pages
+	InternalMsg src;
+	for ( size_t i=0; i<20000; ++i )
+	{
+		src.appendLengthPrefixedString( std::string_view( "[info] request completed in", 10 + i % 18 ) );
+		src.appendUint32( (uint32_t)( i / 3 ) );
+	}
+	src.append( std::string( 100000, 'z' ).data(), 100000 );
+	uint64_t x = 1;
+	for ( size_t i=0; i<30000; ++i )
+	{
+		x = x * 6364136223846793005ull + 1442695040888963407ull;
+		src.appendUint64( x );
+	}
+
+	struct Case { CompressionMethod method; int level; size_t blockSize; bool checksum; };
+	const Case cases[] = {
+		{ CompressionMethod::lz4, 0, 0x10000, false },
+		{ CompressionMethod::lz4, -8, 0x400, true },
+		{ CompressionMethod::lz4, 9, CompressionOptions::maxBlockSize, true },
+		{ CompressionMethod::zstd, 0, 0x10000, false },
+		{ CompressionMethod::zstd, -5, 0x400, true },
+		{ CompressionMethod::zstd, 9, CompressionOptions::maxBlockSize, true },
+	};
+	for ( const Case& c : cases )
+		for ( size_t start : { (size_t)0, (size_t)1000 } )
+		{
+			CompressionOptions options;
+			options.method = c.method;
+			options.level = c.level;
+			options.blockSize = c.blockSize;
+			options.checksum = c.checksum;
+			size_t sz = src.size() - start - 3;
+			InternalMsg compressed;
+			compress( src.getReadIter( start ), sz, compressed, options );
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, compressed.size() < sz * 2 / 3, "{} vs. {}", compressed.size(), sz );
+			// standard frames, as the command line tools have them
+			uint32_t magic = compressed.getReadIter().readUint32();
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, magic == ( c.method == CompressionMethod::lz4 ? 0x184D2204u : 0xFD2FB528u ), "0x{:x}", magic );
+			InternalMsg restored;
+			restored.append( "hdr", 3 );
+			decompress( compressed.getReadIter(), compressed.size(), restored, c.method );
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, restored.size() == sz + 3, "{} vs. {}", restored.size(), sz );
+			auto it1 = restored.getReadIter( 3 );
+			auto it2 = src.getReadIter( start );
+			for ( size_t i=0; i<sz; ++i )
+				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it1.readChar() == it2.readChar(), "at {}", i );
+
+			// truncated, corrupted (caught by the checksum, if not earlier), or with garbage after a frame
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, decompressFails( compressed, compressed.size() - 1, c.method ) );
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, decompressFails( compressed, 7, c.method ) );
+			if ( c.checksum )
+			{
+				InternalMsg corrupted;
+				corrupted.append( compressed.getReadIter(), compressed.size() );
+				corrupted.template patchLE<uint8_t>( compressed.size() / 2, (uint8_t)( corrupted.getReadIter( compressed.size() / 2 ).readChar() ^ 0x10 ) );
+				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, decompressFails( corrupted, corrupted.size(), c.method ) );
+			}
+			compressed.append( "garbage!", 8 );
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, decompressFails( compressed, compressed.size(), c.method ) );
+		}
+
+	// nothing, a few bytes, and two frames one after another
+	for ( CompressionMethod method : { CompressionMethod::lz4, CompressionMethod::zstd } )
+	{
+		CompressionOptions options;
+		options.method = method;
+		for ( size_t sz : { 0, 1, 12, 13, 20 } )
+		{
+			InternalMsg small;
+			small.append( "0123456789abcdefghij", sz );
+			InternalMsg compressed;
+			compress( small.getReadIter(), sz, compressed, options );
+			compress( small.getReadIter(), sz, compressed, options );
+			InternalMsg restored;
+			decompress( compressed.getReadIter(), compressed.size(), restored, method );
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, restored.size() == 2 * sz );
+		}
+		InternalMsg empty;
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, decompressFails( empty, 0, method ) );
+	}
+}
+
+template<class PageProvider>
+void testInternalMsgSmall_()
+{
+	using namespace nodecpp::platform::internal_msg;
+	using MsgT = InternalMsgImpl<PageProvider>;
+	const size_t cellData = PageProvider::cellSize - MsgT::total_reserved;
+
+	// growing byte by byte, and by pieces, through the moment a message moves from its cell to a page
+	MsgT msg;
+	MsgT msg2;
+	for ( size_t i=0; i<cellData + 100; ++i )
+	{
+		msg.appendUint8( (uint8_t)( i * 7 + 5 ) );
+		if ( i == 10 || i == cellData - 2 || i == cellData - 1 || i == cellData )
+			checkMsg( msg, 0, i + 1, 5 );
+	}
+	checkMsg( msg, 0, cellData + 100, 5 );
+	fillMsg( msg2, cellData - 1, 6 );
+	checkMsg( msg2, 0, cellData - 1, 6 );
+	fillMsg( msg2, 2 * MsgT::pageSize, 6 + (uint8_t)( ( cellData - 1 ) * 7 ) );
+	checkMsg( msg2, 0, cellData - 1 + 2 * MsgT::pageSize, 6 );
+
+	// a small message stays small through moves, conversions to pointers, patching, and reuse
+	MsgT small;
+	small.appendUint32( 0 );
+	small.appendLengthPrefixedString( "hello" );
+	small.template patchLE<uint32_t>( 0, (uint32_t)small.size() );
+	MsgT moved( std::move( small ) );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, small.size() == 0 );
+	MsgT restored;
+	restored.restoreFromPointer( moved.convertToPointer() );
+	auto it = restored.getReadIter();
+	std::string buff;
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.directlyAvailableSize() == restored.size() && it.readUint32() == restored.size() );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.readLengthPrefixedString( buff ) == "hello" && !it.isData() );
+	restored.clear();
+	fillMsg( restored, MsgT::pageSize, 8 );
+	checkMsg( restored, 0, MsgT::pageSize, 8 );
+
+	// appended from another message
+	MsgT copy;
+	copy.append( msg.getReadIter(), 20 );
+	copy.append( msg2.getReadIter(), msg2.size() );
+	checkMsg( copy, 0, 20, 5 );
+	auto it2 = copy.getReadIter( 20 );
+	for ( size_t i=0; i<msg2.size(); ++i )
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, (uint8_t)it2.readChar() == (uint8_t)( i * 7 + 6 ), "at {}", i );
+}
+
+void testInternalMsgSmall()
+{
+	using namespace nodecpp::platform::internal_msg;
+	testInternalMsgSmall_<PoolPageProvider>();
+	testInternalMsgSmall_<MallocPageProvider>();
+}
+
+template<size_t pageSize_>
+void testInternalMsgPageSize_()
+{
+	using namespace nodecpp::platform::internal_msg;
+	using MsgT = InternalMsgImpl<MallocPageProviderT<pageSize_>>;
+	const size_t sz = 100 * pageSize_ + 33;
+	MsgT msg;
+	fillMsg( msg, sz, 11 );
+	checkMsg( msg, 0, sz, 11 );
+
+	const size_t firstPageData = pageSize_ - MsgT::total_reserved;
+	for ( size_t offset : { (size_t)0, firstPageData - 1, firstPageData, firstPageData + 70 * pageSize_ + 1, sz - 1 } )
+	{
+		auto it = msg.getReadIter( offset );
+		for ( size_t i=0; i<sz - offset && i<pageSize_ + 1; ++i )
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, (uint8_t)it.readChar() == (uint8_t)( ( offset + i ) * 7 + 11 ), "at {} + {}", offset, i );
+	}
+
+	MsgT copy;
+	copy.append( msg.getReadIter(), msg.size() );
+	uint64_t val = 0x1122334455667788ull;
+	copy.template patchLE<uint64_t>( firstPageData + 5 * pageSize_ - 3, val );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, copy.getReadIter( firstPageData + 5 * pageSize_ - 3 ).readUint64() == val );
+	checkMsg( copy, 0, firstPageData + 5 * pageSize_ - 3, 11 );
+
+	MsgT typed;
+	for ( size_t i=0; i<pageSize_; ++i )
+		typed.appendUint64( i );
+	auto it = typed.getReadIter();
+	for ( size_t i=0; i<pageSize_; ++i )
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.readUint64() == i, "at {}", i );
+}
+
+void testInternalMsgPageSizes()
+{
+	testInternalMsgPageSize_<nodecpp::platform::internal_msg::minPageSize>();
+	testInternalMsgPageSize_<0x10000>();
+}
+
+template<class BasePageProvider>
+struct CountingPageProviderT : public BasePageProvider
+{
+	using PagePointer = typename BasePageProvider::PagePointer;
+	static inline size_t pages = 0;
+	static inline size_t cells = 0;
+	static PagePointer acquirePage() { ++pages; return BasePageProvider::acquirePage(); }
+	static void releasePage( PagePointer page ) { --pages; BasePageProvider::releasePage( page ); }
+	static PagePointer acquireCell() { ++cells; return BasePageProvider::acquireCell(); }
+	static void releaseCell( PagePointer cell ) { --cells; BasePageProvider::releaseCell( cell ); }
+};
+using CountingPageProvider = CountingPageProviderT<nodecpp::platform::internal_msg::MallocPageProvider>;
+
+void testInternalMsgIndex()
+{
+	using namespace nodecpp::platform::internal_msg;
+	using MsgT = InternalMsgImpl<CountingPageProvider>;
+	const size_t firstPageData = pageSize - MsgT::total_reserved;
+	const size_t firstIndexCapacity = ( CountingPageProvider::cellSize - 2 * sizeof( void* ) ) / sizeof( void* );
+	const size_t indexCapacity = ( pageSize - 2 * sizeof( void* ) ) / sizeof( void* );
+
+	// a message of a few pages takes a cell for its index, not a page; further index pages are pages
+	{
+		MsgT msg;
+		fillMsg( msg, firstPageData + 5 * pageSize, 5 );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, CountingPageProvider::pages == 6 && CountingPageProvider::cells == 1, "{}, {}", CountingPageProvider::pages, CountingPageProvider::cells );
+		msg.clear();
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, CountingPageProvider::pages == 0 && CountingPageProvider::cells == 0 );
+
+		// and is filled again after being cleared
+		fillMsg( msg, firstPageData + 8 * pageSize, 6 );
+		checkMsg( msg, 0, firstPageData + 8 * pageSize, 6 );
+	}
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, CountingPageProvider::pages == 0 && CountingPageProvider::cells == 0 );
+
+	// around ends of index pages: reading through, random access, copying
+	for ( size_t pageCnt : { 4 + firstIndexCapacity, 5 + firstIndexCapacity, 4 + firstIndexCapacity + indexCapacity, 5 + firstIndexCapacity + indexCapacity } )
+	{
+		{
+			MsgT msg;
+			size_t sz = firstPageData + ( pageCnt - 2 ) * pageSize + 1; // the last page has a byte
+			fillMsg( msg, sz, 7 );
+			size_t indexPages = pageCnt > 4 + firstIndexCapacity + indexCapacity ? 2 : ( pageCnt > 4 + firstIndexCapacity ? 1 : 0 );
+			size_t dirPages = indexPages > 1 ? 1 : 0; // a single index page past the cell is the directory itself
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, CountingPageProvider::pages == pageCnt + indexPages + dirPages && CountingPageProvider::cells == 1, "{}: {}, {}", pageCnt, CountingPageProvider::pages, CountingPageProvider::cells );
+			checkMsg( msg, 0, sz, 7 );
+			for ( size_t k : { (size_t)3, firstIndexCapacity + 3, firstIndexCapacity + 4, pageCnt - 1 } ) // 4 + firstIndexCapacity is the first page beyond the cell
+			{
+				if ( k >= pageCnt )
+					continue;
+				size_t offset = firstPageData + ( k - 1 ) * pageSize - 2;
+				auto it = msg.getReadIter( offset );
+				for ( size_t i=0; i<pageSize + 4 && i<sz - offset; ++i )
+					NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, (uint8_t)it.readChar() == (uint8_t)( ( offset + i ) * 7 + 7 ), "{}: at {} + {}", pageCnt, offset, i );
+			}
+			MsgT copy;
+			copy.append( msg.getReadIter(), msg.size() );
+			checkMsg( copy, 0, sz, 7 );
+		}
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, CountingPageProvider::pages == 0 && CountingPageProvider::cells == 0 );
+	}
+
+	// with small pages, the directory of index pages takes two levels: random access and patching across them
+	using SmallProvider = CountingPageProviderT<MallocPageProviderT<minPageSize>>;
+	using SmallMsgT = InternalMsgImpl<SmallProvider>;
+	const size_t smallFirstPageData = minPageSize - SmallMsgT::total_reserved;
+	const size_t smallIndexCapacity = ( minPageSize - 2 * sizeof( void* ) ) / sizeof( void* );
+	const size_t smallDirCapacity = minPageSize / sizeof( void* );
+	for ( size_t dirIndexPages : { smallDirCapacity, smallDirCapacity + 1, 2 * smallDirCapacity + 3 } )
+	{
+		{
+			SmallMsgT msg;
+			size_t pageCnt = 4 + smallIndexCapacity + dirIndexPages * smallIndexCapacity;
+			size_t sz = smallFirstPageData + ( pageCnt - 2 ) * minPageSize + 1;
+			fillMsg( msg, sz, 3 );
+			size_t dirPages = dirIndexPages > smallDirCapacity ? 1 + ( dirIndexPages + smallDirCapacity - 1 ) / smallDirCapacity : 1;
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, SmallProvider::pages == pageCnt + 1 + dirIndexPages + dirPages, "{}: {}", pageCnt, SmallProvider::pages );
+			for ( size_t offset = 1; offset < sz; offset = offset * 3 + 17 )
+			{
+				auto it = msg.getReadIter( offset );
+				for ( size_t i=0; i<minPageSize + 4 && i<sz - offset; ++i )
+					NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, (uint8_t)it.readChar() == (uint8_t)( ( offset + i ) * 7 + 3 ), "{}: at {} + {}", pageCnt, offset, i );
+			}
+			// a patch over several index pages
+			std::vector<uint8_t> data( 3 * smallIndexCapacity * minPageSize );
+			for ( size_t i=0; i<data.size(); ++i )
+				data[i] = (uint8_t)( i * 5 + 1 );
+			size_t at = sz - data.size() - 10;
+			msg.patch( at, data.data(), data.size() );
+			auto it = msg.getReadIter( at - 1 );
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, (uint8_t)it.readChar() == (uint8_t)( ( at - 1 ) * 7 + 3 ) );
+			for ( size_t i=0; i<data.size(); ++i )
+				NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, (uint8_t)it.readChar() == data[i], "at {} + {}", at, i );
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, (uint8_t)it.readChar() == (uint8_t)( ( at + data.size() ) * 7 + 3 ) );
+		}
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, SmallProvider::pages == 0 && SmallProvider::cells == 0 );
+	}
+}
+
+template<class PageProvider>
+void testInternalMsgClone_()
+{
+	using namespace nodecpp::platform::internal_msg;
+	using MsgT = InternalMsgImpl<PageProvider>;
+	constexpr size_t cloneCnt = 8;
+	const size_t sz = 30 * pageSize + 100;
+
+	// clones read as the source, and go on on their own
+	MsgT src;
+	fillMsg( src, sz, 9 );
+	uint64_t appData = 0x1122334455667788ull;
+	src.appWriteData( &appData, 16, sizeof( appData ) );
+	std::vector<MsgT> clones;
+	for ( size_t i=0; i<cloneCnt; ++i )
+		clones.push_back( src.clone() );
+	src.append( "src", 3 );
+	src.template patchLE<uint32_t>( 2 * pageSize, 0xdeadbeef );
+	for ( size_t i=0; i<cloneCnt; ++i )
+	{
+		uint64_t data = 0;
+		clones[i].appReadData( &data, 16, sizeof( data ) );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, data == appData && clones[i].size() == sz );
+		clones[i].template patchLE<uint32_t>( 3 * pageSize + i, (uint32_t)i );
+		clones[i].appendUint64( i );
+	}
+	for ( size_t i=0; i<cloneCnt; ++i )
+	{
+		checkMsg( clones[i], 0, 3 * pageSize + i, 9 );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, clones[i].getReadIter( 3 * pageSize + i ).readUint32() == i );
+		auto it = clones[i].getReadIter( 3 * pageSize + i + 4 );
+		for ( size_t j=3 * pageSize + i + 4; j<sz; ++j )
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, (uint8_t)it.readChar() == (uint8_t)( j * 7 + 9 ), "{}: at {}", i, j );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.readUint64() == i && !it.isData() );
+	}
+	checkMsg( src, 0, 2 * pageSize, 9 );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, src.getReadIter( 2 * pageSize ).readUint32() == 0xdeadbeef );
+	checkMsg( src, 3 * pageSize, sz - 3 * pageSize - 4, 9 );
+
+	// the source is gone, clones stay
+	src.clear();
+	clones.erase( clones.begin() );
+	checkMsg( clones.back(), 0, 3 * pageSize, 9 );
+
+	// small (in a cell, if any) and empty ones
+	MsgT small;
+	small.appendUint32( 5 );
+	MsgT smallClone = small.clone();
+	small.appendUint32( 6 );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, smallClone.size() == 4 && smallClone.getReadIter().readUint32() == 5 );
+	MsgT empty;
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, empty.clone().size() == 0 );
+}
+
+void testInternalMsgClone()
+{
+	testInternalMsgClone_<nodecpp::platform::internal_msg::PoolPageProvider>();
+	testInternalMsgClone_<nodecpp::platform::internal_msg::MallocPageProvider>();
+}
+
+#include <internal_msg_queue.h>
+#include <thread>
+void testInternalMsgQueue()
+{
+	using namespace nodecpp::platform::internal_msg;
+	constexpr size_t producerCnt = 4;
+	constexpr size_t msgCnt = 3000;
+	InternalMsgQueue queue;
+
+	// a message keeps its content and app_reserved data; an empty one comes out empty
+	{
+		InternalMsg msg;
+		fillMsg( msg, 2 * pageSize, 3 );
+		uint64_t appData = 0x123456789abcdefull;
+		msg.appWriteData( &appData, 8, sizeof( appData ) );
+		queue.push( msg );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, msg.size() == 0 && !queue.empty() );
+		InternalMsg empty;
+		queue.push( empty );
+		InternalMsg out;
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, queue.pop( out ) && out.size() == 2 * pageSize );
+		checkMsg( out, 0, 2 * pageSize, 3 );
+		appData = 0;
+		out.appReadData( &appData, 8, sizeof( appData ) );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, appData == 0x123456789abcdefull );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, queue.pop( out ) && out.size() == 0 );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, !queue.pop( out ) && queue.empty() );
+	}
+
+	// messages of each producer come out in order
+	std::thread producers[producerCnt];
+	for ( size_t p=0; p<producerCnt; ++p )
+		producers[p] = std::thread( [&queue, p]() {
+			for ( size_t i=0; i<msgCnt; ++i )
+			{
+				InternalMsg msg;
+				msg.appendUint32( (uint32_t)p );
+				msg.appendUint32( (uint32_t)i );
+				if ( i % 100 == 0 )
+					fillMsg( msg, pageSize, (uint8_t)i );
+				queue.push( msg );
+			}
+		} );
+	size_t expected[producerCnt] = {};
+	size_t received = 0;
+	InternalMsg batch[16];
+	while ( received < producerCnt * msgCnt )
+	{
+		size_t cnt = queue.popBatch( batch, std::size( batch ) );
+		if ( cnt == 0 )
+			std::this_thread::yield();
+		for ( size_t j=0; j<cnt; ++j )
+		{
+			auto it = batch[j].getReadIter();
+			uint32_t p = it.readUint32();
+			uint32_t i = it.readUint32();
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, p < producerCnt && i == expected[p], "{}: {} vs. {}", p, i, expected[p] );
+			++expected[p];
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, batch[j].size() == ( i % 100 == 0 ? 8 + pageSize : 8 ) );
+			if ( i % 100 == 0 )
+				checkMsg( batch[j], 8, pageSize, (uint8_t)i );
+		}
+		received += cnt;
+	}
+	for ( auto& t : producers )
+		t.join();
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, queue.empty() );
+
+	// the queue releases whatever is left in it
+	for ( size_t i=0; i<10; ++i )
+	{
+		InternalMsg msg;
+		fillMsg( msg, i * 1000, 1 );
+		queue.push( msg );
+	}
+}
+
+#ifndef NODECPP_WINDOWS
+#include <unistd.h>
+void testInternalMsgScatterGather()
+{
+	using namespace nodecpp::platform::internal_msg;
+	constexpr size_t sz = 0x23456;
+	constexpr size_t maxVecs = 8; // to make partial gathers happen
+	IoVec vecs[maxVecs];
+
+	FILE* f = tmpfile();
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, f != nullptr );
+	int fd = fileno( f );
+
+	// gather: the reserved prefix is not there, partial writes are continued
+	InternalMsg src;
+	fillMsg( src, sz, 5 );
+	auto it = src.getReadIter();
+	while ( it.isData() )
+	{
+		size_t cnt = it.gather( vecs, maxVecs );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, cnt != 0 );
+		ssize_t written = writev( fd, vecs, (int)cnt );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, written > 0 );
+		it.skip( written );
+	}
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, lseek( fd, 0, SEEK_CUR ) == (off_t)sz );
+
+	// scatter: read right into pages of a message, both into an empty one and after some data
+	for ( size_t prefix : { (size_t)0, (size_t)3, pageSize - InternalMsg::total_reserved } )
+	{
+		lseek( fd, 0, SEEK_SET );
+		InternalMsg dst;
+		fillMsg( dst, prefix, 6 );
+		for (;;)
+		{
+			size_t cnt = dst.prepareReceive( vecs, maxVecs );
+			ssize_t rd = readv( fd, vecs, (int)cnt );
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, rd >= 0 );
+			dst.commitReceive( vecs, cnt, rd );
+			if ( rd == 0 )
+				break;
+		}
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, dst.size() == prefix + sz, "{} vs. {}", dst.size(), prefix + sz );
+		checkMsg( dst, 0, prefix, 6 );
+		checkMsg( dst, prefix, sz, 5 );
+		dst.append( "xyz", 3 );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, dst.size() == prefix + sz + 3 );
+	}
+	fclose( f );
+}
+
+#include <mapped_file.h>
+#include <fcntl.h>
+void testMappedFile()
+{
+	using namespace nodecpp::platform::internal_msg;
+	constexpr size_t recordCnt = 100000;
+	char path[] = "/tmp/nodecpp_mapped_file_XXXXXX";
+	int fd = mkstemp( path );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, fd != -1 );
+
+	// a file written from a message is read through the same ReadIter
+	InternalMsg src;
+	for ( size_t i=0; i<recordCnt; ++i )
+	{
+		src.appendUint32( (uint32_t)i );
+		src.appendVarUint( i * 1000 );
+		src.appendLengthPrefixedString( std::string_view( "abcdefghijklmnop", i % 17 ) );
+	}
+	IoVec vecs[16];
+	auto it = src.getReadIter();
+	while ( it.isData() )
+	{
+		ssize_t written = writev( fd, vecs, (int)it.gather( vecs, std::size( vecs ) ) );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, written > 0 );
+		it.skip( written );
+	}
+	close( fd );
+
+	MappedFile file( path );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, file.size() == src.size() );
+	auto fit = file.getReadIter();
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, fit.directlyAvailableSize() == file.size() );
+	std::string buff;
+	for ( size_t i=0; i<recordCnt; ++i )
+	{
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, fit.readUint32() == i && fit.readVarUint() == i * 1000, "at {}", i );
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, fit.readLengthPrefixedString( buff ) == std::string_view( "abcdefghijklmnop", i % 17 ), "at {}", i );
+	}
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, !fit.isData() && fit.offset() == file.size() );
+
+	// a part of it goes to a message
+	InternalMsg copy;
+	fit = file.getReadIter();
+	fit.skip( 3 );
+	copy.append( fit, file.size() - 10 );
+	auto it1 = copy.getReadIter();
+	auto it2 = src.getReadIter();
+	it2.skip( 3 );
+	for ( size_t i=0; i<copy.size(); ++i )
+		NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it1.readChar() == it2.readChar(), "at {}", i );
+
+	// empty and missing files
+	MappedFile moved( std::move( file ) );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, file.size() == 0 && moved.size() == src.size() );
+	fd = open( path, O_WRONLY | O_TRUNC );
+	close( fd );
+	moved.open( path );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, moved.size() == 0 && !moved.getReadIter().isData() );
+	unlink( path );
+	bool thrown = false;
+	try
+	{
+		moved.open( path );
+	}
+	catch ( nodecpp::error::error e )
+	{
+		thrown = e == nodecpp::error::no_such_file_or_directory;
+	}
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, thrown );
+}
+
+#include <internal_msg_shm.h>
+#include <sys/wait.h>
+#include <sched.h>
+void testInternalMsgShm()
+{
+	using namespace nodecpp::platform::internal_msg;
+	using nodecpp::ShmPagePool;
+	constexpr size_t msgCnt = 200;
+	auto sizeOf = []( size_t i ) { return i == 100 ? 0x300000 : ( i * 7919 ) % 30000; }; // 0x300000: more than one index page
+
+	// pages are referred to by offsets, so that a message survives remapping at another address
+	constexpr const char* name = "/nodecpp_test_shm";
+	ShmPagePool::remove( name );
+	int fd = ShmPagePool::create( 0x100000, name );
+	ShmInternalMsg msg;
+	fillMsg( msg, 3 * pageSize, 1 );
+	uint64_t offset = ShmPagePool::toOffset( msg.convertToPointer() );
+	uint8_t* prevBase = ShmPagePool::base();
+	close( fd );
+	fd = ShmPagePool::attach( name );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, ShmPagePool::base() != prevBase );
+	msg.restoreFromPointer( reinterpret_cast<ShmInternalMsg*>( ShmPagePool::fromOffset( offset ) ) );
+	checkMsg( msg, 0, 3 * pageSize, 1 );
+	msg.clear();
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, ShmPagePool::usedPages() == 0 );
+	ShmPagePool::detach();
+	close( fd );
+	ShmPagePool::remove( name );
+
+	// a child process consumes messages of its parent and releases their pages; replies go back the other way
+	fd = ShmPagePool::create( 0x2000000 );
+	ShmMsgChannel toChild( 0 );
+	ShmMsgChannel toParent( 1 );
+	uint8_t* parentBase = ShmPagePool::base();
+	pid_t pid = fork();
+	if ( pid == 0 )
+	{
+		int ret = 1;
+		try
+		{
+			ShmPagePool::attach( fd );
+			for ( size_t i=0; i<msgCnt; )
+			{
+				ShmInternalMsg in;
+				if ( !toChild.pop( in ) )
+				{
+					sched_yield();
+					continue;
+				}
+				checkMsg( in, 0, sizeOf( i ), (uint8_t)i );
+				ShmInternalMsg reply;
+				reply.appendUint64( in.size() );
+				reply.appendUint8( ShmPagePool::base() != parentBase );
+				while ( !toParent.push( reply ) )
+					sched_yield();
+				++i;
+			}
+			ret = 0;
+		}
+		catch (...) {}
+		_exit( ret );
+	}
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, pid > 0 );
+	size_t replies = 0;
+	for ( size_t i=0; i<msgCnt || replies<msgCnt; )
+	{
+		ShmInternalMsg reply;
+		if ( toParent.pop( reply ) )
+		{
+			auto it = reply.getReadIter();
+			NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, it.readUint64() == sizeOf( replies ) && it.readUint8() == 1 );
+			++replies;
+		}
+		else if ( i < msgCnt )
+		{
+			ShmInternalMsg out;
+			fillMsg( out, sizeOf( i ), (uint8_t)i );
+			while ( !toChild.push( out ) )
+				sched_yield();
+			++i;
+		}
+		else
+			sched_yield();
+	}
+	int status = 0;
+	waitpid( pid, &status, 0 );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, WIFEXITED( status ) && WEXITSTATUS( status ) == 0, "status {}", status );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, ShmPagePool::usedPages() == 0, "{}", ShmPagePool::usedPages() );
+	ShmPagePool::detach();
+	close( fd );
+}
+#endif // NODECPP_WINDOWS
+
 /*#include <allocator_template.h>
 struct LargeAndAligned
 {
@@ -398,6 +1317,23 @@ int main(int argc, char *argv[])
 		nodecpp::log::default_log::warning( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "whatever warning # {}", 2000+i );
 
 	testVectorOfPages();
+	testInternalMsgSplice();
+	testInternalMsgTypedAccess();
+	testInternalMsgRandomAccess();
+	testInternalMsgSmall();
+	testInternalMsgWriter();
+	testInternalMsgPageSizes();
+	testInternalMsgIndex();
+	testInternalMsgClone();
+	testInternalMsgQueue();
+	testChecksums();
+	testInternalMsgCompress();
+#ifndef NODECPP_WINDOWS
+	testInternalMsgScatterGather();
+	testInternalMsgShm();
+	testMappedFile();
+#endif
+	testPageAllocator();
 //	return 0;
 
 	printPlatform();
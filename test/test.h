@@ -29,5 +29,6 @@
 #define TEST_NODECPP_FOUNDATIONS
 
 void testSEH();
+void testPageAllocator();
 
 #endif // TEST_NODECPP_FOUNDATIONS
\ No newline at end of file
@@ -0,0 +1,542 @@
+/* -------------------------------------------------------------------------------
+* Copyright (c) 2020, OLogN Technologies AG
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the OLogN Technologies AG nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL OLogN Technologies AG BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* -------------------------------------------------------------------------------*/
+
+#include <foundation.h>
+#include <nodecpp_assert.h>
+#include <page_allocator.h>
+#include <page_cache.h>
+#include <page_pool.h>
+#include <arena_allocator.h>
+#include <memory_accounting.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+#include "test.h"
+#if defined NODECPP_LINUX || defined NODECPP_ANDROID
+#include <sys/mman.h>
+#include <cstdio>
+#endif
+
+using namespace nodecpp;
+
+static void touchAndCheck( void* ptr, size_t size, size_t step )
+{
+	uint8_t* bytes = reinterpret_cast<uint8_t*>( ptr );
+	for ( size_t i=0; i<size; i+=step )
+		bytes[i] = (uint8_t)(i / step);
+	for ( size_t i=0; i<size; i+=step )
+		NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, bytes[i] == (uint8_t)(i / step) );
+}
+
+#if defined NODECPP_LINUX || defined NODECPP_ANDROID
+// whether the mapping containing addr is accessible at all, as /proc/self/maps tells
+static bool isAccessible( const void* addr )
+{
+	FILE* f = fopen( "/proc/self/maps", "r" );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, f != nullptr );
+	char line[512];
+	bool ret = false;
+	while ( fgets( line, sizeof(line), f ) )
+	{
+		unsigned long long from, to;
+		char perms[5];
+		if ( sscanf( line, "%llx-%llx %4s", &from, &to, perms ) == 3 && from <= (uintptr_t)addr && (uintptr_t)addr < to )
+		{
+			ret = memcmp( perms, "---", 3 ) != 0;
+			break;
+		}
+	}
+	fclose( f );
+	return ret;
+}
+#endif
+
+static void testLargePages()
+{
+	size_t lpSize = VirtualMemory::getLargePageSize();
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, lpSize >= VirtualMemory::getPageSize() );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, ( lpSize & ( lpSize - 1 ) ) == 0, "{:x}", lpSize );
+
+	size_t effectivePageSize = 0;
+	void* ptr = VirtualMemory::allocate( 2 * lpSize, VirtualMemory::largePages, &effectivePageSize );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, ptr != nullptr );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, effectivePageSize == lpSize || effectivePageSize == VirtualMemory::getPageSize(), "{:x}", effectivePageSize );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, ( (uintptr_t)ptr & ( effectivePageSize - 1 ) ) == 0 );
+	touchAndCheck( ptr, 2 * lpSize, VirtualMemory::getPageSize() );
+	VirtualMemory::deallocate( ptr, 2 * lpSize );
+	nodecpp::log::default_log::info( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "large page size: 0x{:x}, effective page size obtained: 0x{:x}", lpSize, effectivePageSize );
+
+	ptr = VirtualMemory::allocate( 3 * VirtualMemory::getPageSize(), VirtualMemory::noFlags, &effectivePageSize );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, effectivePageSize == VirtualMemory::getPageSize() );
+	touchAndCheck( ptr, 3 * VirtualMemory::getPageSize(), 1 );
+	VirtualMemory::deallocate( ptr, 3 * VirtualMemory::getPageSize() );
+}
+
+static void testCommitDecommit()
+{
+	size_t pageSize = VirtualMemory::getPageSize();
+	constexpr size_t pageCnt = 16;
+	uint8_t* base = reinterpret_cast<uint8_t*>( VirtualMemory::AllocateAddressSpace( pageCnt * pageSize ) );
+	for ( size_t round=0; round<3; ++round )
+	{
+		VirtualMemory::CommitMemory( base, pageCnt * pageSize );
+		touchAndCheck( base, pageCnt * pageSize, 64 );
+		VirtualMemory::DecommitMemory( base, pageCnt * pageSize );
+	}
+
+	// with commit charge given back: range is not accessible until committed again
+	VirtualMemory::CommitMemory( base, pageCnt * pageSize );
+	touchAndCheck( base, pageCnt * pageSize, 64 );
+	VirtualMemory::DecommitMemory( base, pageCnt * pageSize, VirtualMemory::releaseCommitCharge );
+#if defined NODECPP_LINUX || defined NODECPP_ANDROID
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, !isAccessible( base ) );
+#endif
+	VirtualMemory::CommitMemory( base, pageCnt * pageSize );
+#if defined NODECPP_LINUX || defined NODECPP_ANDROID
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, isAccessible( base ) );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, base[pageSize] == 0 );
+#endif
+	touchAndCheck( base, pageCnt * pageSize, 64 );
+	VirtualMemory::DecommitMemory( base, pageCnt * pageSize );
+
+	// batched: two adjacent ranges (coalesced), a gap, and one more
+	VirtualMemory::CommitMemory( base, pageCnt * pageSize );
+	touchAndCheck( base, pageCnt * pageSize, 64 );
+	VirtualMemory::MemoryRange ranges[] = {
+		{ base, 2 * pageSize },
+		{ base + 2 * pageSize, 3 * pageSize },
+		{ base + 8 * pageSize, pageSize },
+	};
+	VirtualMemory::DecommitMemory( ranges, sizeof(ranges) / sizeof(ranges[0]) );
+	// pages that were not in the list must keep their content
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, base[5 * pageSize] == (uint8_t)(5 * pageSize / 64) );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, base[9 * pageSize] == (uint8_t)(9 * pageSize / 64) );
+	VirtualMemory::CommitMemory( base, 5 * pageSize );
+	touchAndCheck( base, 5 * pageSize, 64 );
+	VirtualMemory::MemoryRange committed[] = {
+		{ base, 8 * pageSize },
+		{ base + 9 * pageSize, ( pageCnt - 9 ) * pageSize },
+	};
+	VirtualMemory::DecommitMemory( committed, sizeof(committed) / sizeof(committed[0]) );
+	VirtualMemory::FreeAddressSpace( base, pageCnt * pageSize );
+}
+
+static void testAllocateMany()
+{
+	size_t pageSize = VirtualMemory::getPageSize();
+	constexpr size_t cnt = 64;
+	void* blocks[cnt];
+	VirtualMemory::allocateMany( blocks, cnt, 2 * pageSize );
+	for ( size_t i=0; i<cnt; ++i )
+		touchAndCheck( blocks[i], 2 * pageSize, 64 );
+	// blocks are independent: some of them go separately, others (including a non-adjacent pair) in one call
+	VirtualMemory::deallocate( blocks[5], 2 * pageSize );
+	VirtualMemory::deallocate( blocks[cnt - 1], 2 * pageSize );
+	VirtualMemory::deallocateMany( blocks, 5, 2 * pageSize );
+	touchAndCheck( blocks[6], 2 * pageSize, 64 );
+	VirtualMemory::deallocateMany( blocks + 6, cnt - 7, 2 * pageSize );
+
+#if defined NODECPP_LINUX || defined NODECPP_ANDROID
+	// total size does not fit into size_t (other platforms allocate blocks one by one and would fill 'blocks' first)
+	bool thrown = false;
+	try { VirtualMemory::allocateMany( blocks, std::numeric_limits<size_t>::max() / ( 2 * pageSize ) + 1, 2 * pageSize ); }
+	catch ( std::bad_alloc& ) { thrown = true; }
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, thrown );
+#endif
+}
+
+// number of pages of a range that are currently in RAM (or all of them, where we cannot tell)
+static size_t residentPages( void* ptr, size_t size )
+{
+	size_t pageCnt = ( size + VirtualMemory::getPageSize() - 1 ) / VirtualMemory::getPageSize();
+#if defined NODECPP_LINUX || defined NODECPP_ANDROID
+	std::vector<unsigned char> vec( pageCnt );
+	if ( mincore( ptr, size, vec.data() ) != 0 )
+		return pageCnt;
+	size_t ret = 0;
+	for ( auto v : vec )
+		ret += v & 1;
+	return ret;
+#else
+	return pageCnt;
+#endif
+}
+
+static void testPrefault()
+{
+	size_t pageSize = VirtualMemory::getPageSize();
+	constexpr size_t pageCnt = 32;
+	void* ptr = VirtualMemory::allocate( pageCnt * pageSize, VirtualMemory::prefault );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, residentPages( ptr, pageCnt * pageSize ) == pageCnt, "{}", residentPages( ptr, pageCnt * pageSize ) );
+	touchAndCheck( ptr, pageCnt * pageSize, 64 );
+	VirtualMemory::deallocate( ptr, pageCnt * pageSize );
+
+	ptr = VirtualMemory::allocate( pageCnt * pageSize, VirtualMemory::lockInMemory ); // locking itself may be refused
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, residentPages( ptr, pageCnt * pageSize ) == pageCnt );
+	VirtualMemory::ResetMemory( ptr, pageCnt * pageSize ); // locked pages can be reset ...
+	touchAndCheck( ptr, pageCnt * pageSize, 64 );
+	VirtualMemory::deallocate( ptr, pageCnt * pageSize );
+
+	// ... and decommitted, and locked again as they are committed again
+	uint8_t* base = reinterpret_cast<uint8_t*>( VirtualMemory::AllocateAddressSpace( pageCnt * pageSize ) );
+	VirtualMemory::CommitMemory( base, pageCnt * pageSize, VirtualMemory::lockInMemory );
+	touchAndCheck( base, pageCnt * pageSize, 64 );
+	VirtualMemory::DecommitMemory( base, pageCnt * pageSize / 2 );
+	VirtualMemory::CommitMemory( base, pageCnt * pageSize / 2, VirtualMemory::lockInMemory );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, residentPages( base, pageCnt * pageSize ) == pageCnt );
+	VirtualMemory::DecommitMemory( base, pageCnt * pageSize, VirtualMemory::releaseCommitCharge );
+	VirtualMemory::FreeAddressSpace( base, pageCnt * pageSize );
+
+	// prefaulting keeps content, even if not page-aligned
+	ptr = VirtualMemory::allocate( pageCnt * pageSize );
+	touchAndCheck( ptr, pageSize, 1 );
+	VirtualMemory::PrefaultMemory( reinterpret_cast<uint8_t*>( ptr ) + 100, ( pageCnt - 1 ) * pageSize );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, residentPages( ptr, pageCnt * pageSize ) == pageCnt );
+	for ( size_t i=0; i<pageSize; ++i )
+		NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, reinterpret_cast<uint8_t*>( ptr )[i] == (uint8_t)i );
+	VirtualMemory::deallocate( ptr, pageCnt * pageSize );
+
+	// arenas: memory committed on demand is populated right away; commitAhead() goes beyond what is in use
+	ArenaAllocator arena( 64 * pageSize, 4 * pageSize, VirtualMemory::prefault );
+	uint8_t* first = reinterpret_cast<uint8_t*>( arena.allocate( 1 ) );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, residentPages( first, 4 * pageSize ) == 4 );
+	ArenaAllocator lazyArena( 64 * pageSize, 4 * pageSize );
+	first = reinterpret_cast<uint8_t*>( lazyArena.allocate( 1 ) );
+	lazyArena.commitAhead( 10 * pageSize );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, lazyArena.committedSize() >= 10 * pageSize );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, residentPages( first, 10 * pageSize ) == 10 );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, lazyArena.usedSize() == 1 );
+	lazyArena.commitAhead( 1000 * pageSize ); // up to the end of reserved range
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, lazyArena.committedSize() == lazyArena.reservedSize() );
+
+	// a locked arena gives memory back, too
+	ArenaAllocator lockedArena( 64 * pageSize, 4 * pageSize, VirtualMemory::lockInMemory );
+	touchAndCheck( lockedArena.allocate( 16 * pageSize ), 16 * pageSize, 64 );
+	lockedArena.reset();
+	lockedArena.releaseUnused();
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, lockedArena.committedSize() == 0 );
+	touchAndCheck( lockedArena.allocate( 16 * pageSize ), 16 * pageSize, 64 );
+}
+
+static void testPageCache()
+{
+	size_t pageSize = VirtualMemory::getPageSize();
+
+	// recently released runs are reused by the same thread
+	void* run = PageCache::acquire( 2 );
+	touchAndCheck( run, 2 * pageSize, 1 );
+	PageCache::release( run, 2 );
+	void* run2 = PageCache::acquire( 2 );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, run == run2 );
+	PageCache::release( run2, 2 );
+
+	// overflow of a thread cache goes to a global list and is then available for other threads
+	constexpr size_t runCnt = 4 * PageCache::threadCacheDepth;
+	std::vector<void*> runs;
+	for ( size_t i=0; i<runCnt; ++i )
+	{
+		runs.push_back( PageCache::acquire( 1 ) );
+		touchAndCheck( runs.back(), pageSize, 64 );
+	}
+	size_t cachedBefore = PageCache::cachedBytes();
+	for ( auto r : runs )
+		PageCache::release( r, 1 );
+	PageCache::flushThreadCache();
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, PageCache::cachedBytes() >= cachedBefore + runCnt * pageSize, "{} vs. {}", PageCache::cachedBytes(), cachedBefore );
+
+	size_t reused = 0;
+	std::thread t( [&]() {
+		for ( size_t i=0; i<runCnt; ++i )
+		{
+			void* r = PageCache::acquire( 1 );
+			for ( auto known : runs )
+				if ( known == r )
+				{
+					++reused;
+					break;
+				}
+			touchAndCheck( r, pageSize, 64 );
+			PageCache::release( r, 1 );
+		}
+	} );
+	t.join();
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, reused != 0 );
+
+	// over high-water mark, memory is given back to OS, but runs are still usable
+	size_t hwm = PageCache::getHighWaterMark();
+	PageCache::setHighWaterMark( 0 );
+	PageCache::trim();
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, PageCache::residentCachedBytes() < PageCache::cachedBytes(), "{} vs. {}", PageCache::residentCachedBytes(), PageCache::cachedBytes() );
+	runs.clear();
+	for ( size_t i=0; i<runCnt; ++i )
+	{
+		runs.push_back( PageCache::acquire( 1 ) );
+		touchAndCheck( runs.back(), pageSize, 64 );
+	}
+	for ( auto r : runs )
+		PageCache::release( r, 1 );
+	PageCache::setHighWaterMark( hwm );
+
+	// long runs are not cached, but are served all the same
+	run = PageCache::acquire( PageCache::maxCachedRunPages + 1 );
+	touchAndCheck( run, ( PageCache::maxCachedRunPages + 1 ) * pageSize, 64 );
+	PageCache::release( run, PageCache::maxCachedRunPages + 1 );
+
+	// batches: from a thread cache, from global lists, and from OS, all at once
+	std::vector<void*> many( 3 * runCnt );
+	PageCache::acquireMany( many.data(), many.size(), 1 );
+	for ( size_t i=0; i<many.size(); ++i )
+	{
+		touchAndCheck( many[i], pageSize, 64 );
+		for ( size_t j=0; j<i; ++j )
+			NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, many[i] != many[j] );
+	}
+	PageCache::releaseMany( many.data(), many.size(), 1 );
+	many.resize( 4 );
+	PageCache::acquireMany( many.data(), many.size(), PageCache::maxCachedRunPages + 1 );
+	for ( auto r : many )
+		touchAndCheck( r, ( PageCache::maxCachedRunPages + 1 ) * pageSize, 64 );
+	PageCache::releaseMany( many.data(), many.size(), PageCache::maxCachedRunPages + 1 );
+
+	nodecpp::log::default_log::info( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "page cache: 0x{:x} bytes cached, 0x{:x} resident", PageCache::cachedBytes(), PageCache::residentCachedBytes() );
+}
+
+static void testPagePool()
+{
+	// recently released pages are reused by the same thread
+	void* page = PagePool::acquirePage();
+	touchAndCheck( page, PagePool::pageSize, 1 );
+	PagePool::releasePage( page );
+	void* page2 = PagePool::acquirePage();
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, page == page2 );
+	PagePool::releasePage( page2 );
+
+	// pages are aligned and distinct across chunks and thread cache overflows
+	constexpr size_t pageCnt = 3 * PagePool::batchPages + 10;
+	std::vector<void*> pages;
+	for ( size_t i=0; i<pageCnt; ++i )
+	{
+		pages.push_back( PagePool::acquirePage() );
+		NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, ( reinterpret_cast<uintptr_t>( pages.back() ) & ( PagePool::pageSize - 1 ) ) == 0 );
+		touchAndCheck( pages.back(), PagePool::pageSize, 64 );
+	}
+	std::vector<void*> sorted = pages;
+	std::sort( sorted.begin(), sorted.end() );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, std::adjacent_find( sorted.begin(), sorted.end() ) == sorted.end() );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, PagePool::reservedBytes() >= pageCnt * PagePool::pageSize && PagePool::reservedBytes() % PagePool::chunkSize == 0 );
+
+	// pages released by one thread are available to others
+	for ( auto p : pages )
+		PagePool::releasePage( p );
+	PagePool::flushThreadCache();
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, PagePool::globalCachedPages() >= pageCnt, "{} vs. {}", PagePool::globalCachedPages(), pageCnt );
+	size_t reservedBefore = PagePool::reservedBytes();
+	size_t reused = 0;
+	std::thread t( [&]() {
+		std::vector<void*> own;
+		for ( size_t i=0; i<pageCnt; ++i )
+		{
+			own.push_back( PagePool::acquirePage() );
+			if ( std::binary_search( sorted.begin(), sorted.end(), own.back() ) )
+				++reused;
+			touchAndCheck( own.back(), PagePool::pageSize, 64 );
+		}
+		for ( auto p : own )
+			PagePool::releasePage( p );
+	} );
+	t.join();
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, reused != 0 );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, PagePool::reservedBytes() == reservedBefore );
+
+	// pages released by another thread go back to their owner, and are reused by it before anything else but its own cached pages
+	PagePool::flushThreadCache();
+	pages.clear();
+	std::vector<void*> owned;
+	for ( size_t i=0; i<pageCnt; ++i )
+	{
+		pages.push_back( PagePool::acquirePage() );
+		if ( PagePool::isOwnedByCallingThread( pages.back() ) )
+			owned.push_back( pages.back() );
+	}
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, owned.size() != 0 );
+	std::thread consumer( [&]() {
+		for ( auto p : pages )
+			PagePool::releasePage( p );
+	} );
+	consumer.join();
+	std::sort( owned.begin(), owned.end() );
+	pages.clear();
+	size_t returned = 0;
+	for ( size_t i=0; i<owned.size() + PagePool::batchPages; ++i )
+	{
+		pages.push_back( PagePool::acquirePage() );
+		if ( std::binary_search( owned.begin(), owned.end(), pages.back() ) )
+			++returned;
+	}
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, returned == owned.size(), "{} vs. {}", returned, owned.size() );
+	for ( auto p : pages )
+		PagePool::releasePage( p );
+
+	// cells are aligned and distinct, and can be released by any thread
+	constexpr size_t cellCnt = 3 * PagePool::cellBatch + 10;
+	std::vector<void*> cells;
+	for ( size_t i=0; i<cellCnt; ++i )
+	{
+		cells.push_back( PagePool::acquireCell() );
+		NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, ( reinterpret_cast<uintptr_t>( cells.back() ) & ( PagePool::cellSize - 1 ) ) == 0 );
+		touchAndCheck( cells.back(), PagePool::cellSize, 16 );
+	}
+	sorted = cells;
+	std::sort( sorted.begin(), sorted.end() );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, std::adjacent_find( sorted.begin(), sorted.end() ) == sorted.end() );
+	std::thread cellConsumer( [&]() {
+		for ( auto c : cells )
+			PagePool::releaseCell( c );
+	} );
+	cellConsumer.join();
+	for ( size_t i=0; i<cellCnt; ++i )
+	{
+		cells[i] = PagePool::acquireCell();
+		touchAndCheck( cells[i], PagePool::cellSize, 16 );
+	}
+	for ( auto c : cells )
+		PagePool::releaseCell( c );
+
+	nodecpp::log::default_log::info( nodecpp::log::ModuleID(nodecpp::foundation_module_id), "page pool: 0x{:x} bytes reserved, {} pages in global list", PagePool::reservedBytes(), PagePool::globalCachedPages() );
+}
+
+static void testArenaAllocator()
+{
+	size_t pageSize = VirtualMemory::getPageSize();
+	ArenaAllocator arena( 64 * pageSize, 4 * pageSize );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, arena.committedSize() == 0 );
+
+	uint8_t* first = arena.allocate<uint8_t>( 3 );
+	uint64_t* aligned = arena.allocate<uint64_t>( 2 );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, ( (uintptr_t)aligned & ( alignof(uint64_t) - 1 ) ) == 0 );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, (uint8_t*)aligned >= first + 3 );
+	void* overAligned = arena.allocate( 1, 256 );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, ( (uintptr_t)overAligned & 255 ) == 0 );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, arena.committedSize() == 4 * pageSize );
+
+	// crossing a commit chunk boundary
+	ArenaAllocator::Checkpoint cp = arena.checkpoint();
+	size_t usedAtCp = arena.usedSize();
+	void* big = arena.allocate( 10 * pageSize );
+	touchAndCheck( big, 10 * pageSize, 1 );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, arena.committedSize() == 12 * pageSize, "0x{:x}", arena.committedSize() );
+
+	// rewind: the same addresses are handed out again
+	arena.rewind( cp );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, arena.usedSize() == usedAtCp );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, arena.allocate( 10 * pageSize ) == big );
+
+	arena.reset();
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, arena.usedSize() == 0 );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, arena.allocate<uint8_t>( 3 ) == first );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, arena.committedSize() == 12 * pageSize );
+
+	arena.releaseUnused( 2 * pageSize );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, arena.committedSize() == 2 * pageSize );
+	arena.releaseUnused( 0, VirtualMemory::releaseCommitCharge );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, arena.committedSize() == pageSize );
+	touchAndCheck( arena.allocate( 5 * pageSize ), 5 * pageSize, 64 ); // recommits
+
+	// exhausting reserved space
+	bool thrown = false;
+	try { arena.allocate( 64 * pageSize ); } 
+	catch ( std::bad_alloc& ) { thrown = true; }
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, thrown );
+	arena.reset();
+	touchAndCheck( arena.allocate( 64 * pageSize ), 64 * pageSize, 64 ); // the whole of it
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, arena.committedSize() == arena.reservedSize() );
+}
+
+static void testMemoryAccounting()
+{
+	size_t pageSize = VirtualMemory::getPageSize();
+	MemoryAccounting::Stats before = MemoryAccounting::getStats( MemoryTag::arena );
+	MemoryAccounting::enableTrace( true );
+	{
+		ArenaAllocator arena( 64 * pageSize, 4 * pageSize );
+		arena.allocate( 5 * pageSize );
+		MemoryAccounting::Stats inUse = MemoryAccounting::getStats( MemoryTag::arena );
+		NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, inUse.reserved == before.reserved + 64 * pageSize, "0x{:x} vs. 0x{:x}", inUse.reserved, before.reserved );
+		NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, inUse.committed == before.committed + 8 * pageSize, "0x{:x} vs. 0x{:x}", inUse.committed, before.committed );
+		NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, inUse.peakCommitted >= inUse.committed );
+		arena.reset();
+		arena.releaseUnused();
+		NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, MemoryAccounting::getStats( MemoryTag::arena ).committed == before.committed );
+	}
+	MemoryAccounting::Stats after = MemoryAccounting::getStats( MemoryTag::arena );
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, after.reserved == before.reserved && after.committed == before.committed );
+
+	// runs change hands between a user and the cache
+	MemoryAccounting::Stats msgBefore = MemoryAccounting::getStats( MemoryTag::message );
+	void* run = PageCache::acquire( 3, MemoryTag::message );
+	PageCache::flushThreadCache();
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, MemoryAccounting::getStats( MemoryTag::message ).committed == msgBefore.committed + 3 * pageSize );
+	PageCache::release( run, 3, MemoryTag::message );
+	PageCache::flushThreadCache();
+	NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, MemoryAccounting::getStats( MemoryTag::message ).committed == msgBefore.committed );
+	MemoryAccounting::enableTrace( false );
+
+	// the trace: at least reserve/commit/decommit/unreserve of the arena, and the transfers
+	FILE* f = tmpfile();
+	if ( f != nullptr )
+	{
+		MemoryAccounting::dumpTrace( f );
+		size_t lineCnt = 0;
+		bool arenaSeen = false;
+		bool transferSeen = false;
+		char line[256];
+		rewind( f );
+		while ( fgets( line, sizeof(line), f ) )
+		{
+			++lineCnt;
+			arenaSeen = arenaSeen || strstr( line, "arena" ) != nullptr;
+			transferSeen = transferSeen || strstr( line, "transfer in" ) != nullptr;
+		}
+		fclose( f );
+		NODECPP_ASSERT( foundation::module_id, nodecpp::assert::AssertLevel::critical, lineCnt >= 6 && arenaSeen && transferSeen, "{}", lineCnt );
+	}
+	MemoryAccounting::logStats();
+}
+
+void testPageAllocator()
+{
+	testLargePages();
+	testCommitDecommit();
+	testAllocateMany();
+	testPrefault();
+	testPageCache();
+	testPagePool();
+	testArenaAllocator();
+	testMemoryAccounting();
+}
@@ -32,6 +32,10 @@
 #include <cpu_exceptions_translator.h>
 #include <log.h>
 #include <stack_info.h>
+#include <guarded_region_allocator.h>
+#if defined NODECPP_LINUX && !defined NODECPP_CLANG
+#include <ucontext.h>
+#endif
 
 using namespace std;
 
@@ -106,6 +110,91 @@ void badCallOuter_DivByZero()
 	nodecpp::log::default_log::info("we must be dead here" );
 }
 
+#if defined NODECPP_LINUX && !defined NODECPP_CLANG
+// runs on a stack obtained from GuardedRegionAllocator until the stack is exhausted
+static bool fiberStackOverflowCaught = false;
+
+// NOTE: a frame must not be larger than a guard page, otherwise it could just step over it; hence, no inlining
+NODECPP_NOINLINE static size_t recurse( size_t depth )
+{
+	volatile uint8_t frame[0x400];
+	frame[0] = (uint8_t)depth;
+	if ( depth == SIZE_MAX )
+		return 0;
+	return recurse( depth + 1 ) + frame[0];
+}
+
+// called indirectly: otherwise the compiler may see that recurse() cannot throw and drop the handler below
+static size_t (* volatile recurseFn)( size_t ) = recurse;
+
+static void fiberMain()
+{
+	try
+	{
+		recurseFn( 0 );
+	}
+	catch (StackOverflowException& e)
+	{
+		nodecpp::log::default_log::info("{}", e.what() );
+		fiberStackOverflowCaught = true;
+	}
+}
+
+static void testFiberStackOverflow( nodecpp::GuardedRegionAllocator& stacks )
+{
+	void* stack = stacks.allocate();
+	ucontext_t mainCtx, fiberCtx;
+	getcontext( &fiberCtx );
+	fiberCtx.uc_stack.ss_sp = stack;
+	fiberCtx.uc_stack.ss_size = stacks.regionSize();
+	fiberCtx.uc_link = &mainCtx;
+	makecontext( &fiberCtx, fiberMain, 0 );
+	swapcontext( &mainCtx, &fiberCtx );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, fiberStackOverflowCaught );
+	stacks.deallocate( stack );
+}
+#endif // NODECPP_LINUX && !NODECPP_CLANG
+
+static void testGuardedRegions()
+{
+	nodecpp::GuardedRegionAllocator stacks( 0x10000, 4 );
+	uint8_t* stack1 = reinterpret_cast<uint8_t*>( stacks.allocate() );
+	uint8_t* stack2 = reinterpret_cast<uint8_t*>( stacks.allocate() );
+	stack1[0] = 1;
+	stack1[stacks.regionSize() - 1] = 1;
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, nodecpp::GuardedRegionAllocator::isGuardAddress( stack1 - 1 ) );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, nodecpp::GuardedRegionAllocator::isGuardAddress( stack2 + stacks.regionSize() ) );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, !nodecpp::GuardedRegionAllocator::isGuardAddress( stack2 ) );
+
+#if !defined NODECPP_CLANG // SEH implementation for clang is yet to be developed
+	bool caught = false;
+	try
+	{
+		*( reinterpret_cast<volatile uint8_t*>( stack2 ) - 1 ) = 0;
+	}
+	catch (StackOverflowException& e)
+	{
+		nodecpp::log::default_log::info("{}", e.what() );
+		caught = true;
+	}
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, caught );
+#endif // NODECPP_CLANG
+
+	// recycling
+	stacks.deallocate( stack1 );
+	NODECPP_ASSERT( nodecpp::foundation::module_id, nodecpp::assert::AssertLevel::critical, stacks.allocate() == stack1 );
+	stacks.deallocate( stack1 );
+	stacks.trim();
+	stack1 = reinterpret_cast<uint8_t*>( stacks.allocate() );
+	stack1[0] = 1;
+	stacks.deallocate( stack1 );
+
+#if defined NODECPP_LINUX && !defined NODECPP_CLANG
+	testFiberStackOverflow( stacks );
+#endif
+	stacks.deallocate( stack2 );
+}
+
 void testSEH()
 {
     initTranslator();
@@ -131,6 +220,8 @@ void testSEH()
     }
 
     nodecpp::log::default_log::info("... and still working [2]" );
+
+	testGuardedRegions();
 	
     /*try 
 	{